@@ -0,0 +1,300 @@
+#include "synthetic_sequence.hpp"
+#include "../geometry/motion_estimation.hpp"
+#include "../pipeline/camera_stream.hpp"
+#include "../pipeline/latency_recorder.hpp"
+#include "../pipeline/thread_budget.hpp"
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <opencv2/opencv.hpp>
+
+using namespace std;
+using namespace pac;
+
+static void usage() {
+    cout << "usage: ./PitchAngleBenchmark [options]" << endl
+         << "    --frames N             number of synthetic frames (default: 300)" << endl
+         << "    --width W --height H   image size (default: 1280x720)" << endl
+         << "    --dir PATH             directory for the rendered frames (default: temporary)" << endl
+         << "    --keep                 keep the rendered frames" << endl
+         << "    --max-pitch-error DEG  fail if the mean absolute pitch error exceeds DEG" << endl
+         << "    --min-fps FPS          fail if the throughput is below FPS" << endl
+         << "    --fast-foe             benchmark the FOE-based pitch relative to the heading" << endl
+         << "    --features N           track about N features per frame, at least 24 (default: 150)" << endl
+         << "    --sweep-features LIST  run once per comma separated feature count, e.g. 150,1000,5000" << endl
+         << "    --tracker NAME         correspondence engine: lk or dis (default: lk)" << endl
+         << "    --grid N               sampling step of the dis tracker in pixels (default: 16)" << endl
+         << "    --cores N              cores used by the pipeline and OpenCV (default: allowed CPUs)" << endl
+         << "    --affinity LIST        run only on the listed CPUs, e.g. 0-15" << endl;
+}
+
+static double PeakRss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // Linux では KiB 単位
+    return usage.ru_maxrss / 1024.0;
+}
+
+struct BenchmarkResult {
+    long long frames;
+    long long foeFrames;
+    long long skippedFrames;  // 推定できなかったフレーム
+    double fps;
+    double meanError;
+    double rmsError;
+    double maxError;
+};
+
+// 開けないディレクトリは空とみなす (書き込めなければ RenderSyntheticSequence がエラーにする)
+static bool IsEmptyDirectory(const string &path) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL) {
+        return true;
+    }
+    bool empty = true;
+    struct dirent *ent;
+    while (empty && (ent = readdir(dir)) != NULL) {
+        empty = strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0;
+    }
+    closedir(dir);
+    return empty;
+}
+
+static BenchmarkResult RunPipeline(const CameraConfig &config, const StreamOptions &options,
+                                   const vector<SyntheticPose> &poses, int cores, ostream &out) {
+    BenchmarkResult benchmark = {0, 0, 0, 0.0, 0.0, 0.0, 0.0};
+    double errorSum = 0.0;
+    double squaredErrorSum = 0.0;
+    Stopwatch stopwatch;
+    const double processCpuStart = ProcessCpuTime();
+    CameraStream stream(config, options);
+    FrameResult result;
+    while (stream.Step(result)) {
+        // 正解の姿勢がないフレームは評価しない
+        if (result.index >= (long long) poses.size()) {
+            break;
+        }
+        if (!result.estimated) {
+            benchmark.skippedFrames++;
+            continue;
+        }
+        cv::Mat r;
+        cv::Mat t;
+        CalcRelativeMotion(poses[result.index - (options.interval - 1)], poses[result.index], r, t);
+        double truth = options.mode == HEADING_PITCH ? CalcPitchAngleFromTranslation(t) : CalcPitchAngle(r);
+        double error = std::abs(result.pitch - truth) * 180 / M_PI;
+        benchmark.foeFrames += result.estimationPath == FOE_PATH;
+        errorSum += error;
+        squaredErrorSum += error * error;
+        benchmark.maxError = std::max(benchmark.maxError, error);
+        benchmark.frames++;
+    }
+    const double elapsed = stopwatch.Elapsed();
+    const double processCpuTime = ProcessCpuTime() - processCpuStart;
+    benchmark.fps = (benchmark.frames + benchmark.skippedFrames) / (elapsed / 1000);
+    if (benchmark.frames) {
+        benchmark.meanError = errorSum / benchmark.frames;
+        benchmark.rmsError = std::sqrt(squaredErrorSum / benchmark.frames);
+    }
+
+    if (options.tracker.type == DENSE_DIS) {
+        out << "tracker:          dis (grid " << options.tracker.gridStep << " px)" << endl;
+    } else {
+        out << "tracker:          lk (" << options.tracker.features.maxCorners << " features/strip, min distance "
+            << options.tracker.features.minDistance << " px)" << endl;
+    }
+    out << "throughput:       " << benchmark.fps << " frames/s" << endl;
+    out << "latency p50:      " << stream.Latency().Percentile(50) << " ms" << endl;
+    out << "latency p99:      " << stream.Latency().Percentile(99) << " ms" << endl;
+    out << "latency max:      " << stream.Latency().Max() << " ms" << endl;
+    out << "tracking mean:    " << stream.TrackingCost().Mean() << " ms/frame" << endl;
+    PrintStageUtilization(vector<const CameraStream *>(1, &stream), elapsed, 1, processCpuTime, cores, out);
+    if (options.mode == HEADING_PITCH) {
+        out << "FOE path:         " << benchmark.foeFrames << " / " << benchmark.frames << " frames" << endl;
+    }
+    out << "not estimated:    " << benchmark.skippedFrames << " frames" << endl;
+    out << "peak RSS:         " << PeakRss() << " MiB" << endl;
+    out << "pitch error mean: " << benchmark.meanError << " deg" << endl;
+    out << "pitch error rms:  " << benchmark.rmsError << " deg" << endl;
+    out << "pitch error max:  " << benchmark.maxError << " deg" << endl;
+    return benchmark;
+}
+
+int main(int argc, char *argv[]) {
+    SyntheticParameters params;
+    StreamOptions options;
+    vector<int> featureCounts;
+    string directory;
+    bool keep = false;
+    int numCores = 0;
+    vector<int> cpus;
+    double maxPitchError = -1;
+    double minFps = -1;
+
+    const struct option longOptions[] = {
+            {"frames",          required_argument, NULL, 'n'},
+            {"width",           required_argument, NULL, 'W'},
+            {"height",          required_argument, NULL, 'H'},
+            {"dir",             required_argument, NULL, 'd'},
+            {"keep",            no_argument,       NULL, 'k'},
+            {"max-pitch-error", required_argument, NULL, 'e'},
+            {"min-fps",         required_argument, NULL, 'm'},
+            {"fast-foe",        no_argument,       NULL, 'F'},
+            {"features",        required_argument, NULL, 'f'},
+            {"sweep-features",  required_argument, NULL, 'S'},
+            {"tracker",         required_argument, NULL, 'T'},
+            {"grid",            required_argument, NULL, 'g'},
+            {"cores",           required_argument, NULL, 'P'},
+            {"affinity",        required_argument, NULL, 'A'},
+            {"help",            no_argument,       NULL, 'h'},
+            {NULL, 0,                              NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:W:H:d:ke:m:Ff:S:T:g:P:A:h", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                params.numFrames = atoi(optarg);
+                break;
+            case 'W':
+                params.imageSize.width = atoi(optarg);
+                break;
+            case 'H':
+                params.imageSize.height = atoi(optarg);
+                break;
+            case 'd':
+                directory = optarg;
+                break;
+            case 'k':
+                keep = true;
+                break;
+            case 'e':
+                maxPitchError = atof(optarg);
+                break;
+            case 'm':
+                minFps = atof(optarg);
+                break;
+            case 'F':
+                options.mode = HEADING_PITCH;
+                break;
+            case 'f': {
+                int numFeatures;
+                if (!ParseFeatureCount(optarg, numFeatures)) {
+                    usage();
+                    return 1;
+                }
+                featureCounts.assign(1, numFeatures);
+                break;
+            }
+            case 'T':
+                if (!ParseTrackerType(optarg, options.tracker.type)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'g':
+                options.tracker.gridStep = atoi(optarg);
+                break;
+            case 'P':
+                numCores = atoi(optarg);
+                break;
+            case 'A':
+                if (!ParseCpuList(optarg, cpus)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'S': {
+                featureCounts.clear();
+                stringstream list(optarg);
+                string count;
+                int numFeatures;
+                while (getline(list, count, ',')) {
+                    if (!ParseFeatureCount(count, numFeatures)) {
+                        usage();
+                        return 1;
+                    }
+                    featureCounts.push_back(numFeatures);
+                }
+                break;
+            }
+            default:
+                usage();
+                return 1;
+        }
+    }
+    params.camera.principlePoint = cv::Point2f(params.imageSize.width / 2.0f, params.imageSize.height / 2.0f);
+
+    if (params.numFrames <= options.interval) {
+        fprintf(stderr, "error: more than %d frames are required\n", options.interval);
+        return 1;
+    }
+    if (!directory.empty() && !IsEmptyDirectory(directory)) {
+        // 以前に描画したフレームが残っていると正解の姿勢と対応しなくなる
+        fprintf(stderr, "error: %s is not an empty directory\n", directory.c_str());
+        return 1;
+    }
+    if (directory.empty()) {
+        char dirTemplate[] = "/tmp/pac_benchmark_XXXXXX";
+        if (mkdtemp(dirTemplate) == NULL) {
+            fprintf(stderr, "error: cannot create a temporary directory\n");
+            return 1;
+        }
+        directory = dirTemplate;
+    }
+
+    ThreadBudget budget = MakeThreadBudget(numCores, cpus, 1, 1, 0, options.listThreads);
+    ApplyThreadBudget(budget);
+    PrintThreadBudget(budget, cout);
+    options.listThreads = budget.listThreads;
+
+    vector<string> paths;
+    vector<SyntheticPose> poses;
+    Stopwatch renderStopwatch;
+    RenderSyntheticSequence(params, directory, paths, poses);
+    cout << "frames:           " << params.numFrames << " (" << params.imageSize.width << "x"
+         << params.imageSize.height << ", rendered in " << renderStopwatch.Elapsed() / 1000 << "s)" << endl;
+
+    CameraConfig config;
+    config.name = "synthetic";
+    config.directory = directory;
+    config.camera = params.camera;
+    config.principlePointGiven = true;
+    vector<BenchmarkResult> results;
+    if (featureCounts.empty()) {
+        results.push_back(RunPipeline(config, options, poses, budget.cores, cout));
+    }
+    for (int count : featureCounts) {
+        options.tracker.features = MakeFeatureParameters(count);
+        cout << endl << "== " << count << " features" << endl;
+        results.push_back(RunPipeline(config, options, poses, budget.cores, cout));
+    }
+
+    if (!keep) {
+        for (const string &path : paths) {
+            unlink(path.c_str());
+        }
+        rmdir(directory.c_str());
+    }
+
+    bool passed = true;
+    for (const BenchmarkResult &result : results) {
+        if (result.frames == 0) {
+            cout << "FAILED: no frames were processed" << endl;
+            passed = false;
+        }
+        if (maxPitchError >= 0 && result.meanError > maxPitchError) {
+            cout << "FAILED: mean pitch error " << result.meanError << " deg exceeds " << maxPitchError << " deg"
+                 << endl;
+            passed = false;
+        }
+        if (minFps >= 0 && result.fps < minFps) {
+            cout << "FAILED: throughput " << result.fps << " frames/s is below " << minFps << " frames/s" << endl;
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
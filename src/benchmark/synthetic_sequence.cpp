@@ -0,0 +1,147 @@
+#include "synthetic_sequence.hpp"
+
+namespace pac {
+
+// テクスチャは kTextureCells × kTextureCells のランダムな濃淡のマスを拡大したもの
+const int kTextureCells = 128;
+const int kTextureSize = 1024;
+// テクスチャ 1 画素あたりの長さ [m]
+const double kTextureResolution = 0.02;
+const double kSkyIntensity = 200;
+
+SyntheticParameters::SyntheticParameters()
+        : imageSize(1280, 720),
+          numFrames(300),
+          cameraHeight(1.5),
+          speed(0.4),
+          roadHalfWidth(6.0),
+          wallHeight(4.0),
+          maxDistance(60.0),
+          pitchAmplitude(0.5 * M_PI / 180),
+          pitchPeriod(90),
+          seed(1) {
+    camera.focalLength = 1280;
+    camera.principlePoint = cv::Point2f(imageSize.width / 2.0f, imageSize.height / 2.0f);
+}
+
+static void MakeTexture(unsigned int seed, cv::Mat &_texture) {
+    cv::theRNG() = cv::RNG(seed);
+    cv::Mat cells(kTextureCells, kTextureCells, CV_8UC1);
+    cv::randu(cells, cv::Scalar(0), cv::Scalar(256));
+    cv::resize(cells, _texture, cv::Size(kTextureSize, kTextureSize), 0, 0, cv::INTER_NEAREST);
+    // マスの境界を少しぼかしてエイリアシングを抑える
+    cv::GaussianBlur(_texture, _texture, cv::Size(3, 3), 0);
+}
+
+static cv::Mat RotationX(double angle) {
+    cv::Mat r = (cv::Mat_<double>(3, 3) << 1, 0, 0,
+            0, std::cos(angle), -std::sin(angle),
+            0, std::sin(angle), std::cos(angle));
+    return r;
+}
+
+static float Wrap(double coordinate) {
+    // 線形補間が範囲外を参照しないよう, 最後の 1 画素を除いて繰り返す
+    const double period = kTextureSize - 1;
+    double wrapped = std::fmod(coordinate, period);
+    if (wrapped < 0) {
+        wrapped += period;
+    }
+    return static_cast<float>(wrapped);
+}
+
+static void RenderFrame(const SyntheticParameters &params, const SyntheticPose &pose, const cv::Mat &texture,
+                        cv::Mat &_mapX, cv::Mat &_mapY, cv::Mat &_frame) {
+    const double f = params.camera.focalLength;
+    const double cx = params.camera.principlePoint.x;
+    const double cy = params.camera.principlePoint.y;
+    const double *r = pose.rotationMat.ptr<double>(0);
+    const cv::Point3d &c = pose.position;
+    // 路面は y = cameraHeight の平面 (y 軸は下向き), 壁は x = ±roadHalfWidth の平面
+    const double ground = params.cameraHeight;
+    const double wallTop = params.cameraHeight - params.wallHeight;
+    for (int v = 0; v < params.imageSize.height; v++) {
+        float *mapX = _mapX.ptr<float>(v);
+        float *mapY = _mapY.ptr<float>(v);
+        for (int u = 0; u < params.imageSize.width; u++) {
+            const double dx = (u - cx) / f;
+            const double dy = (v - cy) / f;
+            const double wx = r[0] * dx + r[1] * dy + r[2];
+            const double wy = r[3] * dx + r[4] * dy + r[5];
+            const double wz = r[6] * dx + r[7] * dy + r[8];
+            const double length = std::sqrt(wx * wx + wy * wy + wz * wz);
+            double best = params.maxDistance / length;
+            double texU = -1;
+            double texV = -1;
+            bool hit = false;
+            if (wy > 1e-9) {
+                double t = (ground - c.y) / wy;
+                if (t > 0 && t < best) {
+                    best = t;
+                    texU = (c.x + t * wx) / kTextureResolution;
+                    texV = (c.z + t * wz) / kTextureResolution;
+                    hit = true;
+                }
+            }
+            if (std::abs(wx) > 1e-9) {
+                double wall = wx > 0 ? params.roadHalfWidth : -params.roadHalfWidth;
+                double t = (wall - c.x) / wx;
+                double y = c.y + t * wy;
+                if (t > 0 && t < best && y >= wallTop && y <= ground) {
+                    best = t;
+                    // 左右の壁と路面で模様が揃わないようにずらす
+                    texU = (c.z + t * wz) / kTextureResolution + kTextureSize / 3;
+                    texV = y / kTextureResolution + (wx > 0 ? kTextureSize / 2 : 0);
+                    hit = true;
+                }
+            }
+            mapX[u] = hit ? Wrap(texU) : -1.0f;
+            mapY[u] = hit ? Wrap(texV) : -1.0f;
+        }
+    }
+    cv::remap(texture, _frame, _mapX, _mapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(kSkyIntensity));
+}
+
+void RenderSyntheticSequence(const SyntheticParameters &params, const std::string &directory,
+                             std::vector<std::string> &_paths, std::vector<SyntheticPose> &_poses) {
+    cv::Mat texture;
+    MakeTexture(params.seed, texture);
+    std::string dirPath = directory;
+    if (dirPath.empty() || *dirPath.rbegin() != '/') {
+        dirPath.push_back('/');
+    }
+    std::vector<std::string> paths;
+    std::vector<SyntheticPose> poses;
+    cv::Mat mapX(params.imageSize, CV_32FC1);
+    cv::Mat mapY(params.imageSize, CV_32FC1);
+    cv::Mat frame;
+    const std::vector<int> pngParams = {cv::IMWRITE_PNG_COMPRESSION, 1};
+    for (int i = 0; i < params.numFrames; i++) {
+        SyntheticPose pose;
+        double pitch = params.pitchAmplitude * std::sin(2 * M_PI * i / params.pitchPeriod);
+        pose.rotationMat = RotationX(pitch);
+        pose.position = cv::Point3d(0.0, 0.0, params.speed * i);
+        RenderFrame(params, pose, texture, mapX, mapY, frame);
+        std::string path = dirPath + "frame" + std::to_string(i) + ".png";
+        if (!cv::imwrite(path, frame, pngParams)) {
+            fprintf(stderr, "error: cannot write %s\n", path.c_str());
+            exit(1);
+        }
+        paths.push_back(path);
+        poses.push_back(pose);
+    }
+    _paths = paths;
+    _poses = poses;
+}
+
+void CalcRelativeMotion(const SyntheticPose &pose1, const SyntheticPose &pose2, cv::Mat &_rotationMat,
+                        cv::Mat &_translationVec) {
+    // X_c = R^T (X_w - C) より x2 = R2^T R1 x1 + R2^T (C1 - C2)
+    cv::Mat c = (cv::Mat_<double>(3, 1) << pose1.position.x - pose2.position.x,
+            pose1.position.y - pose2.position.y,
+            pose1.position.z - pose2.position.z);
+    _rotationMat = pose2.rotationMat.t() * pose1.rotationMat;
+    _translationVec = pose2.rotationMat.t() * c;
+}
+
+} // namespace pac
@@ -0,0 +1,45 @@
+#ifndef PITCHANGLECORRECTION_SYNTHETIC_SEQUENCE_HPP
+#define PITCHANGLECORRECTION_SYNTHETIC_SEQUENCE_HPP
+
+#include "../image/camera.hpp"
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+// 合成走行シーケンスのパラメータ. 長さの単位は [m], 角度は [rad]
+struct SyntheticParameters {
+    SyntheticParameters();
+
+    cv::Size imageSize;
+    CameraParameters camera;
+    int numFrames;
+    double cameraHeight;   // 路面からの高さ
+    double speed;          // 1 フレームあたりの前進量
+    double roadHalfWidth;  // 車線中心から左右の壁までの距離
+    double wallHeight;
+    double maxDistance;    // これより遠い路面・壁は描画しない
+    double pitchAmplitude;
+    double pitchPeriod;    // [frame]
+    unsigned int seed;
+};
+
+// 各フレームのカメラ姿勢 (カメラ座標系 → 世界座標系の回転) と位置
+struct SyntheticPose {
+    cv::Mat rotationMat;
+    cv::Point3d position;
+};
+
+// テクスチャ付きの路面と左右の壁を, ピッチ角が変化しながら前進するカメラで撮影した画像列を
+// directory に書き出す. ファイル名は frame0.png, frame1.png, ... (ゼロ埋めなし)
+void RenderSyntheticSequence(const SyntheticParameters &params, const std::string &directory,
+                             std::vector<std::string> &_paths, std::vector<SyntheticPose> &_poses);
+
+// 2 フレーム間の相対運動を EstimateMotion と同じ規約 (x2 = R x1 + t) で返す
+void CalcRelativeMotion(const SyntheticPose &pose1, const SyntheticPose &pose2, cv::Mat &_rotationMat,
+                        cv::Mat &_translationVec);
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_SYNTHETIC_SEQUENCE_HPP
@@ -17,19 +17,24 @@ float SolveX(const cv::Vec3f &efficient, float y) {
 void DrawLines(const cv::Mat &image, const std::vector<cv::Vec3f> &lines, cv::Mat &_result, int thickness,
                const cv::Scalar &color) {
     _result = image.clone();
+    DrawLines(_result, lines, thickness, color);
+    return;
+}
+
+void DrawLines(cv::Mat &_image, const std::vector<cv::Vec3f> &lines, int thickness, const cv::Scalar &color) {
     for (cv::Vec3f l : lines) {
         if (l[1]) {
             // Y軸と交わる直線の場合
-            float width = image.size().width;
+            float width = _image.size().width;
             cv::Point2f left = cv::Point2f(0.0, SolveY(l, 0.0));
             cv::Point2f right = cv::Point2f(width, SolveY(l, width));
-            cv::line(_result, left, right, color, thickness);
+            cv::line(_image, left, right, color, thickness);
         } else {
             // Y軸に平行な直線の場合
             float x = -l[2] / l[0];
             cv::Point2f top(x, 0.0);
-            cv::Point2f bottom(x, image.size().height);
-            cv::line(_result, top, bottom, color, thickness);
+            cv::Point2f bottom(x, _image.size().height);
+            cv::line(_image, top, bottom, color, thickness);
         }
     }
     return;
@@ -85,14 +90,8 @@ void CalcLines(const std::vector<cv::Point2f> &point1, const std::vector<cv::Poi
 void DrawEpipolarLines(const cv::Mat &image, const std::vector<cv::Point2f> &points, int whichImage,
                        const cv::Mat &fundamentalMat, cv::Mat &_result,
                        const cv::Point2f &translate) {
-    float point[points.size() * 2];
-    for (int i = 0; i < points.size(); i++) {
-        point[i * 2] = points[i].x;
-        point[i * 2 + 1] = points[i].y;
-    }
-    cv::Mat pointsMat = cv::Mat(1, points.size(), CV_32FC2, point);
     std::vector<cv::Vec3f> lines;
-    cv::computeCorrespondEpilines(pointsMat, whichImage, fundamentalMat, lines);
+    cv::computeCorrespondEpilines(points, whichImage, fundamentalMat, lines);
     DrawLines(image, lines, _result, translate);
 }
 
@@ -19,6 +19,10 @@ void DrawPoints(const cv::Mat &image, const std::vector<cv::Point2f> &points, cv
 void DrawLines(const cv::Mat &image, const std::vector<cv::Vec3f> &lines, cv::Mat &_result, int thickness = 4,
                const cv::Scalar &color = cv::Scalar(0, 0, 255));
 
+// 複製せずに _image へ直接描画する
+void DrawLines(cv::Mat &_image, const std::vector<cv::Vec3f> &lines, int thickness = 4,
+               const cv::Scalar &color = cv::Scalar(0, 0, 255));
+
 void DrawLines(const cv::Mat &image, const std::vector<cv::Vec3f> &lines, cv::Mat &_result, const cv::Point2f &translate,
                int thickness = 2, const cv::Scalar &color = cv::Scalar(0, 0, 255));
 
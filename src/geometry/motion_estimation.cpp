@@ -2,6 +2,9 @@
 
 namespace pac {
 
+const float kFoeMaxResidual = 1.0;
+const float kFoeMinInlierRatio = 0.7;
+
 void CalcFundamentalMat(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
                         std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
                         cv::Mat &_fundamentalMat) {
@@ -41,6 +44,14 @@ void CalcExtrinsicParameters(const std::vector<cv::Point2f> &points1, const std:
                              const cv::Mat &essentialMat, std::vector<cv::Point2f> &_maskedPoints1,
                              std::vector<cv::Point2f> &_maskedPoints2, cv::Mat &_rotationMat,
                              cv::Mat &_translationVec) {
+    CalcExtrinsicParameters(points1, points2, essentialMat, kDefaultCamera, _maskedPoints1, _maskedPoints2,
+                            _rotationMat, _translationVec);
+}
+
+void CalcExtrinsicParameters(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                             const cv::Mat &essentialMat, const CameraParameters &camera,
+                             std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
+                             cv::Mat &_rotationMat, cv::Mat &_translationVec) {
     std::vector<uchar> mask;
     // Parameters:
     //      E           The input essential matrix.
@@ -51,7 +62,8 @@ void CalcExtrinsicParameters(const std::vector<cv::Point2f> &points1, const std:
     //      focal       Focal length of the camera. Note that this function assumes that points1 and points2 are feature points from cameras with same focal length and principle point.
     //      pp          Principle point of the camera.
     //      mask        Input/output mask for inliers in points1 and points2. If it is not empty, then it marks inliers in points1 and points2 for then given essential matrix E. Only these inliers will be used to recover pose. In the output mask only inliers which pass the cheirality check.
-    cv::recoverPose(essentialMat, points1, points2, _rotationMat, _translationVec, kFocalLength, kPrinciplePoint, mask);
+    cv::recoverPose(essentialMat, points1, points2, _rotationMat, _translationVec, camera.focalLength,
+                    camera.principlePoint, mask);
     std::vector<cv::Point2f> maskedPoint1;
     std::vector<cv::Point2f> maskedPoint2;
     for (int i = 0; i < mask.size(); i++) {
@@ -68,30 +80,98 @@ double CalcPitchAngle(const cv::Mat &rotationMat) {
     return asin(-rotationMat.at<double>(1, 2));
 }
 
+double CalcPitchAngle(const cv::Point2f &focusOfExpansion, const CameraParameters &camera) {
+    return atan((camera.principlePoint.y - focusOfExpansion.y) / camera.focalLength);
+}
+
+double CalcPitchAngleFromTranslation(const cv::Mat &translationVec) {
+    // エピポール K t の y 座標は cy + f * ty / tz
+    return atan(-translationVec.at<double>(1) / translationVec.at<double>(2));
+}
+
 
 void EstimateMotion(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
                     std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
                     double &_pitch) {
+    cv::Mat r;
+    cv::Mat t;
+    if (!EstimateMotion(points1, points2, kDefaultCamera, _maskedPoints1, _maskedPoints2, r, t, _pitch)) {
+        std::cerr << "warning: too few correspondences to estimate the motion" << std::endl;
+        return;
+    }
+
+    std::cout << r << std::endl;
+    std::cout << t << std::endl;
+    std::cout << "ピッチ角:" << _pitch * 180 / M_PI << std::endl;
+}
+
+bool EstimateMotion(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                    const CameraParameters &camera, std::vector<cv::Point2f> &_maskedPoints1,
+                    std::vector<cv::Point2f> &_maskedPoints2, cv::Mat &_rotationMat, cv::Mat &_translationVec,
+                    double &_pitch) {
+    // 静止時や模様の少ない路面では追跡の残る点が少なく, findFundamentalMat が空の行列を返す
+    if (points1.size() < kMinMotionPoints) {
+        return false;
+    }
     std::vector<cv::Point2f> maskedPoints1;
     std::vector<cv::Point2f> maskedPoints2;
     cv::Mat f;
     CalcFundamentalMat(points1, points2, maskedPoints1, maskedPoints2, f);
-    double paramK[] = {kFocalLength, 0, kPrinciplePoint.x,
-                       0, kFocalLength, kPrinciplePoint.y,
+    if (f.rows != 3 || f.cols != 3) {
+        return false;
+    }
+    double paramK[] = {camera.focalLength, 0, camera.principlePoint.x,
+                       0, camera.focalLength, camera.principlePoint.y,
                        0, 0, 1};
     cv::Mat k = cv::Mat(3, 3, CV_64FC1, paramK);
     cv::Mat e;
     CalcEssentialMat(f, k, e);
-    cv::Mat r;
-    cv::Mat t;
 
-    CalcExtrinsicParameters(maskedPoints1, maskedPoints2, e, _maskedPoints1, _maskedPoints2, r, t);
-    _pitch = CalcPitchAngle(r);
-
-    std::cout << r << std::endl;
-    std::cout << t << std::endl;
-    std::cout << "ピッチ角:" << _pitch * 180 / M_PI << std::endl;
+    CalcExtrinsicParameters(maskedPoints1, maskedPoints2, e, camera, _maskedPoints1, _maskedPoints2, _rotationMat,
+                            _translationVec);
+    _pitch = CalcPitchAngle(_rotationMat);
+    return true;
 }
 
 
-} // namespace pac
\ No newline at end of file
+bool EstimatePitch(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                   const CameraParameters &camera, std::vector<cv::Point2f> &_maskedPoints1,
+                   std::vector<cv::Point2f> &_maskedPoints2, double &_pitch, EstimationPath &_path) {
+    cv::Point2f foe;
+    std::vector<uchar> inliers;
+    float residual;
+    if (CalcRobustFocusOfExpansion(points1, points2, foe, inliers, residual)) {
+        int count = 0;
+        for (uchar inlier : inliers) {
+            count += inlier;
+        }
+        // 回転成分が大きい, または前進していない場合はフローが FOE に集まらない
+        if (residual <= kFoeMaxResidual && count >= kFoeMinInlierRatio * inliers.size() &&
+            cv::norm(foe - camera.principlePoint) < camera.focalLength) {
+            std::vector<cv::Point2f> maskedPoints1;
+            std::vector<cv::Point2f> maskedPoints2;
+            for (size_t i = 0; i < inliers.size(); i++) {
+                if (inliers[i]) {
+                    maskedPoints1.push_back(points1[i]);
+                    maskedPoints2.push_back(points2[i]);
+                }
+            }
+            _maskedPoints1 = maskedPoints1;
+            _maskedPoints2 = maskedPoints2;
+            _pitch = CalcPitchAngle(foe, camera);
+            _path = FOE_PATH;
+            return true;
+        }
+    }
+    cv::Mat r;
+    cv::Mat t;
+    double rotationPitch;
+    if (!EstimateMotion(points1, points2, camera, _maskedPoints1, _maskedPoints2, r, t, rotationPitch)) {
+        return false;
+    }
+    _pitch = CalcPitchAngleFromTranslation(t);
+    _path = RANSAC_PATH;
+    return true;
+}
+
+} // namespace pac
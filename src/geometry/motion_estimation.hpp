@@ -3,11 +3,21 @@
 
 #include "geometry.hpp"
 #include "../image/camera.hpp"
+#include "../optical_flow/optical_flow.hpp"
 #include <opencv2/opencv.hpp>
 
 
 namespace pac {
 
+// findFundamentalMat (RANSAC) に必要な対応点の数
+const int kMinMotionPoints = 8;
+
+// EstimatePitch がどちらの方法でピッチ角を求めたか
+enum EstimationPath {
+    FOE_PATH,
+    RANSAC_PATH
+};
+
 void CalcFundamentalMat(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
                    std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
                    cv::Mat &_fundamentalMat);
@@ -19,12 +29,36 @@ void CalcExtrinsicParameters(const std::vector<cv::Point2f> &points1, const std:
                              std::vector<cv::Point2f> &_maskedPoints2, cv::Mat &_rotationMat,
                              cv::Mat &_translationVec);
 
+void CalcExtrinsicParameters(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                             const cv::Mat &essentialMat, const CameraParameters &camera,
+                             std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
+                             cv::Mat &_rotationMat, cv::Mat &_translationVec);
+
 double CalcPitchAngle(const cv::Mat &rotationMat);
 
+// 進行方向に対するカメラのピッチ角. FOE が主点より上にあるとき正
+double CalcPitchAngle(const cv::Point2f &focusOfExpansion, const CameraParameters &camera);
+
+// recoverPose の並進ベクトル (= エピポールの方向) から求めた進行方向に対するピッチ角
+double CalcPitchAngleFromTranslation(const cv::Mat &translationVec);
+
 void EstimateMotion(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
                     std::vector<cv::Point2f> &_maskedPoints1, std::vector<cv::Point2f> &_maskedPoints2,
                     double &_pitch);
 
+// 結果を出力しない. 複数カメラを並列に処理する場合はこちらを使う.
+// 対応点が kMinMotionPoints 未満, または基礎行列が求まらない場合は false を返し, 出力引数は変更しない
+bool EstimateMotion(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                    const CameraParameters &camera, std::vector<cv::Point2f> &_maskedPoints1,
+                    std::vector<cv::Point2f> &_maskedPoints2, cv::Mat &_rotationMat, cv::Mat &_translationVec,
+                    double &_pitch);
+
+// 前進時は FOE から進行方向に対するピッチ角を求める. FOE の残差が大きい場合のみ
+// findFundamentalMat → recoverPose で求めた並進ベクトルから同じ角度を求める. 推定できなければ false
+bool EstimatePitch(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                   const CameraParameters &camera, std::vector<cv::Point2f> &_maskedPoints1,
+                   std::vector<cv::Point2f> &_maskedPoints2, double &_pitch, EstimationPath &_path);
+
 } // namespace pac
 
 #endif //PITCHANGLECORRECTION_MOTION_ESTIMATION_HPP
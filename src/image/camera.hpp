@@ -1,12 +1,22 @@
 #ifndef PITCHANGLECORRECTION_CAMERA_HPP
 #define PITCHANGLECORRECTION_CAMERA_HPP
 
+#include <opencv2/opencv.hpp>
+
 namespace pac {
 
 const double kFocalLength = 1280;
 
 const cv::Point2f kPrinciplePoint = cv::Point2f(0.0, 0.0);
 
+// カメラごとの内部パラメータ
+struct CameraParameters {
+    double focalLength;
+    cv::Point2f principlePoint;
+};
+
+const CameraParameters kDefaultCamera = {kFocalLength, kPrinciplePoint};
+
 } // namespace pac
 
 #endif //PITCHANGLECORRECTION_CAMERA_HPP
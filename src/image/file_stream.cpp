@@ -0,0 +1,201 @@
+#include "file_stream.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <dirent.h>
+
+namespace pac {
+
+bool NumericLess(const std::string &a, const std::string &b) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (std::isdigit((unsigned char) a[i]) && std::isdigit((unsigned char) b[j])) {
+            // 先頭の 0 を読み飛ばし, 桁数 → 各桁の順に比較する
+            while (i < a.size() && a[i] == '0') {
+                i++;
+            }
+            while (j < b.size() && b[j] == '0') {
+                j++;
+            }
+            size_t beginA = i;
+            size_t beginB = j;
+            while (i < a.size() && std::isdigit((unsigned char) a[i])) {
+                i++;
+            }
+            while (j < b.size() && std::isdigit((unsigned char) b[j])) {
+                j++;
+            }
+            if (i - beginA != j - beginB) {
+                return i - beginA < j - beginB;
+            }
+            int c = a.compare(beginA, i - beginA, b, beginB, j - beginB);
+            if (c) {
+                return c < 0;
+            }
+        } else {
+            if (a[i] != b[j]) {
+                return (unsigned char) a[i] < (unsigned char) b[j];
+            }
+            i++;
+            j++;
+        }
+    }
+    if (i < a.size() || j < b.size()) {
+        return j < b.size() && i == a.size();
+    }
+    // "01" と "1" のように数値として等しい場合は文字列として比較する
+    return a < b;
+}
+
+bool LessThan(const std::string &a, const std::string &b, SortOrder order) {
+    if (order == NUMERIC_ORDER) {
+        return NumericLess(a, b);
+    }
+    return a < b;
+}
+
+FileStream::FileStream(const std::string &dirPath, SortOrder order, int numThreads)
+        : order_(order),
+          stopped_(false) {
+    std::string path = dirPath;
+    if (path.empty() || *path.rbegin() != '/') {
+        path.push_back('/');
+    }
+    Directory *root = NewDirectory(path);
+    pending_.push_back(root);
+    Cursor cursor = {root, 0};
+    cursors_.push_back(cursor);
+    for (int i = 0; i < std::max(numThreads, 1); i++) {
+        workers_.push_back(std::thread(&FileStream::Run, this));
+    }
+}
+
+FileStream::~FileStream() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    pendingChanged_.notify_all();
+    for (std::thread &worker : workers_) {
+        worker.join();
+    }
+}
+
+bool FileStream::Next(std::string &_filePath) {
+    while (!cursors_.empty()) {
+        Cursor &cursor = cursors_.back();
+        Directory *directory = cursor.directory;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            listedChanged_.wait(lock, [directory] { return directory->listed; });
+        }
+        if (cursor.index == directory->entries.size()) {
+            cursors_.pop_back();
+            continue;
+        }
+        const Entry &entry = directory->entries[cursor.index++];
+        if (entry.directory) {
+            Cursor child = {entry.directory, 0};
+            cursors_.push_back(child);
+            continue;
+        }
+        _filePath = directory->path + entry.name;
+        return true;
+    }
+    return false;
+}
+
+FileStream::Directory *FileStream::NewDirectory(const std::string &path) {
+    std::unique_ptr<Directory> directory(new Directory());
+    directory->path = path;
+    directory->listed = false;
+    directories_.push_back(std::move(directory));
+    return directories_.back().get();
+}
+
+void FileStream::Run() {
+    while (true) {
+        Directory *directory;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pendingChanged_.wait(lock, [this] { return !pending_.empty() || stopped_; });
+            if (stopped_) {
+                return;
+            }
+            directory = pending_.front();
+            pending_.pop_front();
+        }
+        List(directory);
+    }
+}
+
+void FileStream::List(Directory *directory) {
+    std::vector<std::string> names;
+    std::vector<bool> isDirectory;
+    DIR *dir = opendir(directory->path.c_str());
+    if (dir == NULL) {
+        fprintf(stderr, "error: cannot open directory %s\n", directory->path.c_str());
+    } else {
+        struct dirent *ent;
+        while ((ent = readdir(dir)) != NULL) {
+            // "." と ".." を除く
+            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+                continue;
+            }
+            // d_type で判別できない場合だけ stat を呼ぶ
+            bool isDir;
+            if (ent->d_type == DT_DIR) {
+                isDir = true;
+            } else if (ent->d_type == DT_REG) {
+                isDir = false;
+            } else {
+                struct stat statBuf;
+                std::string searchPath = directory->path + ent->d_name;
+                if (stat(searchPath.c_str(), &statBuf) != 0) {
+                    fprintf(stderr, "error: cannot stat %s\n", searchPath.c_str());
+                    continue;
+                }
+                isDir = S_ISDIR(statBuf.st_mode);
+            }
+            names.push_back(ent->d_name);
+            isDirectory.push_back(isDir);
+        }
+        closedir(dir);
+    }
+
+    std::vector<size_t> indices(names.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = i;
+    }
+    const SortOrder order = order_;
+    std::sort(indices.begin(), indices.end(), [&names, order](size_t a, size_t b) {
+        return LessThan(names[a], names[b], order);
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Directory *> children;
+        for (size_t i : indices) {
+            Entry entry;
+            entry.name = names[i];
+            entry.directory = NULL;
+            if (isDirectory[i]) {
+                entry.directory = NewDirectory(directory->path + names[i] + "/");
+                children.push_back(entry.directory);
+            }
+            directory->entries.push_back(entry);
+        }
+        // 先に読まれるサブディレクトリほど先に列挙する
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            pending_.push_front(*it);
+        }
+        directory->listed = true;
+    }
+    pendingChanged_.notify_all();
+    listedChanged_.notify_all();
+}
+
+} // namespace pac
@@ -0,0 +1,75 @@
+#ifndef PITCHANGLECORRECTION_FILE_STREAM_HPP
+#define PITCHANGLECORRECTION_FILE_STREAM_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pac {
+
+enum SortOrder {
+    LEXICOGRAPHIC_ORDER,
+    NUMERIC_ORDER
+};
+
+// 数字の並びを数値として比較する (例: "frame2.png" < "frame10.png")
+bool NumericLess(const std::string &a, const std::string &b);
+
+bool LessThan(const std::string &a, const std::string &b, SortOrder order);
+
+// ディレクトリ以下のファイルパスを深さ優先で順に返す。
+// サブディレクトリの列挙はワーカースレッドで先行して並列に行い、
+// 呼び出し側は先頭のファイルが判明した時点から処理を始められる。
+class FileStream {
+public:
+    FileStream(const std::string &dirPath, SortOrder order = NUMERIC_ORDER, int numThreads = 4);
+
+    ~FileStream();
+
+    // 次のファイルパスを _filePath に入れる. 全て返し終えたら false
+    bool Next(std::string &_filePath);
+
+private:
+    struct Directory;
+
+    struct Entry {
+        std::string name;
+        Directory *directory;  // ファイルの場合は NULL
+    };
+
+    struct Directory {
+        std::string path;
+        bool listed;
+        std::vector<Entry> entries;
+    };
+
+    struct Cursor {
+        Directory *directory;
+        size_t index;
+    };
+
+    Directory *NewDirectory(const std::string &path);
+
+    void Run();
+
+    void List(Directory *directory);
+
+    const SortOrder order_;
+
+    std::vector<std::unique_ptr<Directory>> directories_;
+    std::deque<Directory *> pending_;
+    std::vector<Cursor> cursors_;
+    bool stopped_;
+    std::mutex mutex_;
+    std::condition_variable pendingChanged_;
+    std::condition_variable listedChanged_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_FILE_STREAM_HPP
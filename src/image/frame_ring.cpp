@@ -0,0 +1,55 @@
+#include "frame_ring.hpp"
+#include "image_io.hpp"
+
+namespace pac {
+
+FrameRing::FrameRing(int capacity, ImageMode mode)
+        : capacity_(std::max(capacity, 1)),
+          flags_(mode == GRAY_IMAGE ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR),
+          pool_(capacity_),
+          used_(0) {
+}
+
+void FrameRing::Push(const std::string &filePath) {
+    int slot;
+    if (Full()) {
+        // 参照を外してからデコードすることで, 同じ領域がそのまま再利用される
+        slot = slots_.front();
+        slots_.pop_front();
+        frames_.pop_front();
+        paths_.pop_front();
+    } else {
+        slot = used_++;
+    }
+    readImage(filePath, flags_, pool_[slot]);
+    if (used_ == 1 && slots_.empty()) {
+        // 最初のフレームの大きさで残りのバッファも確保しておく
+        for (int i = 1; i < capacity_; i++) {
+            pool_[i].create(pool_[slot].size(), pool_[slot].type());
+        }
+    }
+    slots_.push_back(slot);
+    frames_.push_back(pool_[slot]);
+    paths_.push_back(filePath);
+}
+
+void FrameRing::Clear() {
+    slots_.clear();
+    frames_.clear();
+    paths_.clear();
+    used_ = 0;
+}
+
+const std::deque<cv::Mat> &FrameRing::Frames() const {
+    return frames_;
+}
+
+const std::deque<std::string> &FrameRing::Paths() const {
+    return paths_;
+}
+
+bool FrameRing::Full() const {
+    return static_cast<int>(slots_.size()) == capacity_;
+}
+
+} // namespace pac
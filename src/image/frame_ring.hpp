@@ -0,0 +1,45 @@
+#ifndef PITCHANGLECORRECTION_FRAME_RING_HPP
+#define PITCHANGLECORRECTION_FRAME_RING_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+enum ImageMode {
+    GRAY_IMAGE,
+    COLOR_IMAGE
+};
+
+// スライディングウィンドウ用の固定枚数の画像バッファ。
+// 最も古いフレームのバッファへ次のフレームを直接デコードするため、定常状態では画像の確保が起きない。
+class FrameRing {
+public:
+    explicit FrameRing(int capacity, ImageMode mode = GRAY_IMAGE);
+
+    // ウィンドウが埋まっている場合は最も古いフレームを捨てて filePath を末尾に追加する
+    void Push(const std::string &filePath);
+
+    void Clear();
+
+    const std::deque<cv::Mat> &Frames() const;
+
+    const std::deque<std::string> &Paths() const;
+
+    bool Full() const;
+
+private:
+    const int capacity_;
+    const int flags_;
+    std::vector<cv::Mat> pool_;
+    std::deque<int> slots_;
+    std::deque<cv::Mat> frames_;
+    std::deque<std::string> paths_;
+    int used_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_FRAME_RING_HPP
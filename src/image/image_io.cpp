@@ -3,71 +3,19 @@
 namespace pac
 {
 
-void SearchDir(std::string DirPath, std::vector<std::string> &_filePaths)
+void SearchDir(std::string DirPath, std::vector<std::string> &_filePaths, SortOrder order)
 {
     std::vector<std::string> filePaths;
-    int i, dirElements;
-    std::string searchPath;
-
-    struct stat statBuf;
-    struct dirent **nameList = NULL;
-
-    if (*DirPath.rbegin() != '/')
-    {
-        DirPath.push_back('/');
-    }
-
-    // dirElements にはディレクトリ内の要素数が入る
-    dirElements = scandir(DirPath.c_str(), &nameList, NULL, NULL);
-
-    if (dirElements == -1)
-    {
-        std::cout << "ERROR" << std::endl;
-    }
-    else
+    FileStream stream(DirPath, order);
+    std::string filePath;
+    while (stream.Next(filePath))
     {
-
-        //ディレクトリかファイルかを順番に識別
-        for (i = 0; i < dirElements; i += 1)
-        {
-
-            // "." と ".." を除く
-            if ((strcmp(nameList[i]->d_name, ".\0") != 0) && (strcmp(nameList[i]->d_name, "..\0") != 0))
-            {
-
-                //search_pathには検索対象のフルパスを格納する
-                searchPath = DirPath + std::string(nameList[i]->d_name);
-
-                // ファイル情報の取得の成功
-                if (stat(searchPath.c_str(), &statBuf) == 0)
-                {
-
-                    // ディレクトリだった場合の処理
-                    if ((statBuf.st_mode & S_IFMT) == S_IFDIR)
-                    {
-                        // 再帰によりディレクトリ内を探索
-                        SearchDir(DirPath + std::string(nameList[i]->d_name) + "/", filePaths);
-                    }
-
-                    //ファイルだった場合の処理
-                    else
-                    {
-                        filePaths.push_back(searchPath);
-                    }
-                }
-
-                // ファイル情報の取得の失敗
-                else
-                {
-                    std::cout << "ERROR" << std::endl
-                              << std::endl;
-                }
-            }
-        }
+        filePaths.push_back(filePath);
     }
-    std::sort(filePaths.begin(), filePaths.end());
+    std::sort(filePaths.begin(), filePaths.end(), [order](const std::string &a, const std::string &b) {
+        return LessThan(a, b, order);
+    });
     _filePaths = filePaths;
-    free(nameList);
 }
 
 cv::Mat readColorImage(const std::string &filePath){
@@ -88,6 +36,43 @@ cv::Mat readGrayImage(const std::string &filePath){
     return image;
 }
 
+void readColorImage(const std::string &filePath, cv::Mat &_image) {
+    readImage(filePath, cv::IMREAD_COLOR, _image);
+}
+
+void readGrayImage(const std::string &filePath, cv::Mat &_image) {
+    readImage(filePath, cv::IMREAD_GRAYSCALE, _image);
+}
+
+void readImage(const std::string &filePath, int flags, cv::Mat &_image) {
+    // ファイルの中身はスレッドごとに使い回すバッファへ読み込む
+    static thread_local std::vector<uchar> buffer;
+    std::ifstream ifs(filePath.c_str(), std::ios::binary);
+    if (!ifs) {
+        fprintf(stderr, "error: image does not exist\n");
+        exit(1);
+    }
+    ifs.seekg(0, std::ios::end);
+    const std::streamoff size = ifs.tellg();
+    // 空のファイルは imdecode に渡すと例外になる
+    if (size <= 0) {
+        fprintf(stderr, "error: cannot read image %s\n", filePath.c_str());
+        exit(1);
+    }
+    buffer.resize(static_cast<size_t>(size));
+    ifs.seekg(0, std::ios::beg);
+    if (!ifs.read(reinterpret_cast<char *>(buffer.data()), buffer.size())) {
+        fprintf(stderr, "error: cannot read image %s\n", filePath.c_str());
+        exit(1);
+    }
+    // _image と同じサイズ・型の画像であれば _image の領域へそのままデコードされる
+    cv::imdecode(buffer, flags, &_image);
+    if (!_image.data) {
+        fprintf(stderr, "error: image does not exist\n");
+        exit(1);
+    }
+}
+
 void showImage(const cv::Mat &image){
     cvNamedWindow("Display Image", CV_WINDOW_AUTOSIZE);
     cv::imshow("Display Image", image);
@@ -1,21 +1,30 @@
 #ifndef PITCHANGLECORRECTION_IMAGE_IO_H
 #define PITCHANGLECORRECTION_IMAGE_IO_H
 
+#include "file_stream.hpp"
+#include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <vector>
-#include <sys/stat.h>
-#include <dirent.h>
 #include <opencv2/opencv.hpp>
 
 
 namespace pac {
 
-void SearchDir(std::string DirPath, std::vector<std::string> &_filePaths);
+// ディレクトリ以下の全ファイルを列挙してからソートして返す. 逐次処理する場合は FileStream を使う
+void SearchDir(std::string DirPath, std::vector<std::string> &_filePaths, SortOrder order = LEXICOGRAPHIC_ORDER);
 
 cv::Mat readColorImage(const std::string &filePath);
 
 cv::Mat readGrayImage(const std::string &filePath);
 
+// _image の領域を再利用してデコードする
+void readColorImage(const std::string &filePath, cv::Mat &_image);
+
+void readGrayImage(const std::string &filePath, cv::Mat &_image);
+
+void readImage(const std::string &filePath, int flags, cv::Mat &_image);
+
 void showImage(const cv::Mat &image);
 
 } // namespace pac
@@ -2,44 +2,338 @@
 #include "optical_flow/optical_flow.hpp"
 #include "geometry/motion_estimation.hpp"
 #include "geometry/geometry.hpp"
+#include "pipeline/camera_stream.hpp"
+#include "pipeline/checkpoint.hpp"
+#include "pipeline/multi_camera.hpp"
+#include "pipeline/thread_budget.hpp"
+#include "pipeline/thread_pool.hpp"
+#include "visualization/visualization_sink.hpp"
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <opencv2/opencv.hpp>
 
 using namespace cv;
 using namespace std;
 using namespace pac;
 
+static void usage() {
+    cout << "usage: ./a.out [options] [images directory path]" << endl
+         << "       ./a.out [options] --cameras CONFIG" << endl
+         << "    --video PATH           write optical flow visualization to a video file" << endl
+         << "    --video-sampling N     write every N-th frame to the video (default: 1)" << endl
+         << "    --video-fps FPS        frame rate of the video (default: 10)" << endl
+         << "    --sort ORDER           frame ordering: numeric or lexicographic (default: numeric)" << endl
+         << "    --list-threads N       threads used to enumerate directories (default: 4)" << endl
+         << "    --cameras CONFIG       process every camera listed in a YAML/XML config concurrently" << endl
+         << "    --cores N              cores shared by the cameras, the pipeline stages and OpenCV" << endl
+         << "                           (default: CPUs allowed for the process, or the size of --affinity)" << endl
+         << "    --affinity LIST        run only on the listed CPUs, e.g. 0-15,32-47" << endl
+         << "    --threads N            worker threads shared by all cameras (default: min(cameras, cores))" << endl
+         << "    --fuse                 also output the median pitch of all cameras per frame; the cameras are" << endl
+         << "                           assumed to be synchronised (same frame rate, no dropped frames), and" << endl
+         << "                           frame_offset in the config aligns cameras that started at different times" << endl
+         << "    --fast-foe             estimate the pitch relative to the heading from the focus of expansion," << endl
+         << "                           falling back to findFundamentalMat/recoverPose when it is unreliable" << endl
+         << "    --features N           track about N features per frame, at least 24 (default: 150)" << endl
+         << "    --dense                track several thousand features per frame" << endl
+         << "    --tracker NAME         correspondence engine: lk (sparse) or dis (dense) (default: lk)" << endl
+         << "    --roi X,Y,W,H          road region for the dis tracker as fractions of the image, inside [0,1]" << endl
+         << "                           (default: 0.1,0.55,0.8,0.4)" << endl
+         << "    --grid N               sampling step of the dis tracker in pixels (default: 16)" << endl
+         << "    --focal-length F       focal length of a single camera in pixels (default: 1280)" << endl
+         << "    --principal-point X,Y  principal point in pixels (default: the image centre with --fast-foe," << endl
+         << "                           (0,0) otherwise)" << endl
+         << "    --output PATH          write the results to a file instead of the standard output" << endl
+         << "    --checkpoint PATH      periodically save the progress to PATH" << endl
+         << "    --checkpoint-interval N  frames between checkpoints (default: 100)" << endl
+         << "    --resume               continue from the checkpoint (requires --output and --checkpoint," << endl
+         << "                           cannot be combined with --video)" << endl;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc < 1) {
-        cout << "usage: ./a.out [images directory path]" << endl;
-    }
-    vector<string> files;
-    SearchDir(argv[1], files);
-
-    const int interval = 6;
-
-    deque<Mat> frames;
-    for (int i = 0; i < interval; i++) {
-        frames.push_back(readColorImage(files[i]));
-    }
-    for (int i = interval; i < files.size(); i++) {
-        std::vector<cv::Point2f> prevFeatures;
-        std::vector<cv::Point2f> currFeatures;
-        CalcOpticalFlowMultFrames(frames, prevFeatures, currFeatures);
-        cv::Mat result = frames.back().clone();
-        //DrawOpticalFlow(frames.back(),prevFeatures,currFeatures,STRAIGHT_LINE,result);
-        //Point2f eof;
-        //CalcFocusOfExpansion(frames.back(),prevFeatures,currFeatures,eof);
-        //circle(result,eof,8,Scalar(255,0,0),6);
-        std::vector<cv::Point2f> maskedPrevFeatures;
-        std::vector<cv::Point2f> maskedCurrFeatures;
-        double pitch;
-        EstimateMotion(prevFeatures, currFeatures,maskedPrevFeatures,maskedCurrFeatures,pitch);
-        DrawOpticalFlow(frames.back(),maskedPrevFeatures,maskedCurrFeatures,STRAIGHT_LINE,result);
-        showImage(result);
-        frames.pop_front();
-        frames.push_back(readColorImage(files[i]));
+    string videoPath;
+    int videoSampling = 1;
+    double videoFps = 10.0;
+    StreamOptions options;
+    CameraParameters camera = kDefaultCamera;
+    bool principlePointGiven = false;
+    string camerasPath;
+    int numThreads = 0;
+    int numCores = 0;
+    vector<int> cpus;
+    bool fuse = false;
+    string outputPath;
+    string checkpointPath;
+    int checkpointInterval = 100;
+    bool resume = false;
+
+    const struct option longOptions[] = {
+            {"video",          required_argument, NULL, 'v'},
+            {"video-sampling", required_argument, NULL, 's'},
+            {"video-fps",      required_argument, NULL, 'f'},
+            {"sort",           required_argument, NULL, 'o'},
+            {"list-threads",   required_argument, NULL, 'l'},
+            {"cameras",        required_argument, NULL, 'c'},
+            {"threads",        required_argument, NULL, 't'},
+            {"cores",          required_argument, NULL, 'P'},
+            {"affinity",       required_argument, NULL, 'A'},
+            {"fuse",           no_argument,       NULL, 'u'},
+            {"fast-foe",       no_argument,       NULL, 'F'},
+            {"features",       required_argument, NULL, 'n'},
+            {"dense",          no_argument,       NULL, 'd'},
+            {"tracker",        required_argument, NULL, 'T'},
+            {"roi",            required_argument, NULL, 'r'},
+            {"grid",           required_argument, NULL, 'g'},
+            {"focal-length",   required_argument, NULL, 'L'},
+            {"principal-point", required_argument, NULL, 'p'},
+            {"output",         required_argument, NULL, 'O'},
+            {"checkpoint",     required_argument, NULL, 'C'},
+            {"checkpoint-interval", required_argument, NULL, 'I'},
+            {"resume",         no_argument,       NULL, 'R'},
+            {"help",           no_argument,       NULL, 'h'},
+            {NULL, 0,                             NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v:s:f:o:l:c:t:P:A:uFn:dT:r:g:L:p:O:C:I:Rh", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'v':
+                videoPath = optarg;
+                break;
+            case 's':
+                videoSampling = atoi(optarg);
+                break;
+            case 'f':
+                videoFps = atof(optarg);
+                break;
+            case 'o':
+                if (string(optarg) == "numeric") {
+                    options.order = NUMERIC_ORDER;
+                } else if (string(optarg) == "lexicographic") {
+                    options.order = LEXICOGRAPHIC_ORDER;
+                } else {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'l':
+                options.listThreads = atoi(optarg);
+                break;
+            case 'c':
+                camerasPath = optarg;
+                break;
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            case 'P':
+                numCores = atoi(optarg);
+                break;
+            case 'A':
+                if (!ParseCpuList(optarg, cpus)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'u':
+                fuse = true;
+                break;
+            case 'F':
+                options.mode = HEADING_PITCH;
+                break;
+            case 'n': {
+                int numFeatures;
+                if (!ParseFeatureCount(optarg, numFeatures)) {
+                    usage();
+                    return 1;
+                }
+                options.tracker.features = MakeFeatureParameters(numFeatures);
+                break;
+            }
+            case 'd':
+                options.tracker.features = kDenseFeatures;
+                break;
+            case 'T':
+                if (!ParseTrackerType(optarg, options.tracker.type)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'r':
+                if (!ParseRoi(optarg, options.tracker.roi)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'g':
+                options.tracker.gridStep = atoi(optarg);
+                break;
+            case 'L':
+                camera.focalLength = atof(optarg);
+                if (camera.focalLength <= 0) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'p':
+                if (sscanf(optarg, "%f,%f", &camera.principlePoint.x, &camera.principlePoint.y) != 2) {
+                    usage();
+                    return 1;
+                }
+                principlePointGiven = true;
+                break;
+            case 'O':
+                outputPath = optarg;
+                break;
+            case 'C':
+                checkpointPath = optarg;
+                break;
+            case 'I':
+                checkpointInterval = std::max(atoi(optarg), 1);
+                break;
+            case 'R':
+                resume = true;
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (!camerasPath.empty()) {
+        vector<CameraConfig> configs;
+        LoadCameraConfigs(camerasPath, configs);
+        ThreadBudget budget = MakeThreadBudget(numCores, cpus, static_cast<int>(configs.size()), numThreads, 0,
+                                               options.listThreads);
+        ApplyThreadBudget(budget);
+        PrintThreadBudget(budget, cerr);
+        options.listThreads = budget.listThreads;
+        // 全カメラで 1 つのスレッドプールを共有する
+        ThreadPool pool(budget.sequenceThreads);
+        MultiCameraRunner runner(configs, options, pool, fuse, cout);
+        runner.Run();
+        runner.PrintLatency(cerr);
+        runner.PrintUtilization(budget.cores, cerr);
+        return 0;
+    }
+
+    if (optind >= argc || (resume && (outputPath.empty() || checkpointPath.empty()))) {
+        usage();
+        return 1;
+    }
+    // VideoWriter は追記できないため, 再開すると以前の動画を上書きしてしまう
+    if (resume && !videoPath.empty()) {
+        fprintf(stderr, "error: --video cannot be used with --resume\n");
+        return 1;
+    }
+    // 可視化スレッドの分を除いたコアを OpenCV に割り当てる
+    ThreadBudget budget = MakeThreadBudget(numCores, cpus, 1, 1, videoPath.empty() ? 0 : 1, options.listThreads);
+    ApplyThreadBudget(budget);
+    PrintThreadBudget(budget, cerr);
+    options.listThreads = budget.listThreads;
+
+    // ディレクトリの列挙を待たず, 先頭の options.interval 枚が揃った時点で処理を始める
+    CameraConfig config;
+    config.camera = camera;
+    config.principlePointGiven = principlePointGiven;
+    config.name = "camera";
+    config.directory = argv[optind];
+    CameraStream stream(config, options);
+
+    // 再開時はチェックポイント以降に書かれた出力を切り捨ててから追記する
+    Checkpoint checkpoint;
+    checkpoint.outputOffset = 0;
+    // チェックポイントがなく出力も空の場合だけ最初から処理する. それ以外で出力を消すことはない
+    bool resumed = false;
+    struct stat fileStat;
+    if (resume && stat(checkpointPath.c_str(), &fileStat) == 0) {
+        if (!LoadCheckpoint(checkpointPath, checkpoint)) {
+            fprintf(stderr, "error: cannot read checkpoint %s\n", checkpointPath.c_str());
+            return 1;
+        }
+        // 出力が保存時より短い場合, truncate は足りない分を 0 で埋めてしまう
+        if (stat(outputPath.c_str(), &fileStat) != 0 || fileStat.st_size < checkpoint.outputOffset) {
+            fprintf(stderr, "error: %s is shorter than the %lld bytes recorded in checkpoint %s\n",
+                    outputPath.c_str(), checkpoint.outputOffset, checkpointPath.c_str());
+            return 1;
+        }
+        resumed = true;
+    } else if (resume && stat(outputPath.c_str(), &fileStat) == 0 && fileStat.st_size > 0) {
+        fprintf(stderr, "error: %s is not empty but checkpoint %s does not exist\n", outputPath.c_str(),
+                checkpointPath.c_str());
+        return 1;
+    }
+    if (resumed) {
+        stream.Restore(checkpoint);
+        cerr << "resume from frame " << checkpoint.frameIndex << endl;
+    }
+    fstream outputFile;
+    if (!outputPath.empty()) {
+        if (resumed) {
+            if (truncate(outputPath.c_str(), checkpoint.outputOffset) != 0) {
+                fprintf(stderr, "error: cannot truncate %s\n", outputPath.c_str());
+                return 1;
+            }
+            outputFile.open(outputPath, ios::in | ios::out | ios::binary);
+            outputFile.seekp(0, ios::end);
+        } else {
+            outputFile.open(outputPath, ios::out | ios::trunc | ios::binary);
+        }
+        if (!outputFile) {
+            fprintf(stderr, "error: cannot open %s\n", outputPath.c_str());
+            return 1;
+        }
+    }
+    ostream &out = outputPath.empty() ? cout : outputFile;
+
+    // 可視化は別スレッドで行う. 推定にはグレー画像のみを使う
+    unique_ptr<VisualizationSink> sink;
+    if (!videoPath.empty()) {
+        sink.reset(new VisualizationSink(videoPath, videoSampling, videoFps));
+    }
+
+    Stopwatch stopwatch;
+    const double processCpuStart = ProcessCpuTime();
+    FrameResult result;
+    long long processed = 0;
+    while (stream.Step(result)) {
+        // 対応点が足りず推定できなかったフレームは出力しない
+        if (result.estimated) {
+            if (!result.rotationMat.empty()) {
+                out << result.rotationMat << endl;
+                out << result.translationVec << endl;
+            }
+            out << "ピッチ角:" << result.pitch * 180 / M_PI << endl;
+            if (options.mode == HEADING_PITCH) {
+                out << "推定方法:" << (result.estimationPath == FOE_PATH ? "FOE" : "RANSAC") << endl;
+            }
+            if (sink) {
+                sink->Push(result.path, std::move(result.maskedPrevFeatures), std::move(result.maskedCurrFeatures));
+            }
+        }
+        // 出力をディスクまで書き出してからチェックポイントを保存する
+        if (!checkpointPath.empty() && ++processed % checkpointInterval == 0) {
+            out.flush();
+            if (!outputPath.empty() && !SyncFile(outputPath)) {
+                fprintf(stderr, "error: cannot sync %s\n", outputPath.c_str());
+                return 1;
+            }
+            stream.Save(checkpoint);
+            checkpoint.outputOffset = outputPath.empty() ? 0 : (long long) outputFile.tellp();
+            SaveCheckpoint(checkpointPath, checkpoint);
+        }
+    }
+    if (sink) {
+        sink->Close();
+    }
+    const double wallTime = stopwatch.Elapsed();
+    const double processCpuTime = ProcessCpuTime() - processCpuStart;
+    stream.Latency().Print(config.name, cerr);
+    stream.TrackingCost().Print(config.name + " tracker " + stream.GetTracker().Name(), cerr);
+    PrintStageUtilization(vector<const CameraStream *>(1, &stream), wallTime, 1, processCpuTime, budget.cores, cerr);
+    if (sink) {
+        PrintUtilization("visualization", sink->BusyTime(), wallTime, 1, cerr);
     }
     return 0;
 }
-
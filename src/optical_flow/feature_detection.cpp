@@ -1,11 +1,38 @@
 #include "feature_detection.hpp"
+#include <climits>
+#include <cstdlib>
 
 namespace pac {
 
-void DetectCorners(const cv::Mat &grayImage, std::vector<cv::Point2f> &_corners) {
-    const int maxCorners = 50;
+const int kSplitNumber = 3;
+static_assert(kMinFeatures >= 8 * kSplitNumber, "kMinFeatures must allow 8 corners per strip");
+
+FeatureParameters MakeFeatureParameters(int numFeatures) {
+    FeatureParameters params = kDefaultFeatures;
+    params.maxCorners = std::max(numFeatures / kSplitNumber, 1);
+    // 点数が増えるほど特徴点間の距離を詰める
+    const int defaultFeatures = kDefaultFeatures.maxCorners * kSplitNumber;
+    if (numFeatures > defaultFeatures) {
+        params.minDistance = std::max(kDefaultFeatures.minDistance * std::sqrt((double) defaultFeatures / numFeatures),
+                                      3.0);
+    }
+    return params;
+}
+
+bool ParseFeatureCount(const std::string &text, int &_numFeatures) {
+    char *end;
+    long numFeatures = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || numFeatures < kMinFeatures || numFeatures > INT_MAX) {
+        return false;
+    }
+    _numFeatures = static_cast<int>(numFeatures);
+    return true;
+}
+
+void DetectCorners(const cv::Mat &grayImage, const FeatureParameters &params, std::vector<cv::Point2f> &_corners) {
+    const int maxCorners = params.maxCorners;
     const double qualityLevel = 0.05;
-    const double minDistance = 25;
+    const double minDistance = params.minDistance;
     const int blockSize = 3;
     const bool useHarrisDetector = false;
     const double k = 0.04;
@@ -44,16 +71,21 @@ void DetectCorners(const cv::Mat &grayImage, std::vector<cv::Point2f> &_corners)
 }
 
 void DetectFeatures(const cv::Mat &image, std::vector<cv::Point2f> &_features) {
+    DetectFeatures(image, kDefaultFeatures, _features);
+}
+
+void DetectFeatures(const cv::Mat &image, const FeatureParameters &params, std::vector<cv::Point2f> &_features) {
     cv::Mat grayImage;
     if (image.channels() == 1) {
-        grayImage = image.clone();
+        grayImage = image;
     } else {
         cv::cvtColor(image, grayImage, cv::COLOR_BGR2GRAY);
     }
 
     std::vector<cv::Point2f> features;
+    features.reserve(params.maxCorners * kSplitNumber);
 
-    const int splitNumber = 3;
+    const int splitNumber = kSplitNumber;
     const int splitHeight = grayImage.rows / splitNumber;
     const int margin = 35;
     const int width = grayImage.cols - 1;
@@ -63,7 +95,7 @@ void DetectFeatures(const cv::Mat &image, std::vector<cv::Point2f> &_features) {
         cv::Rect roi(0, splitHeight * i, grayImage.cols, splitHeight);
         cv::Mat splitGrayImage = grayImage(roi);
         std::vector<cv::Point2f> corners;
-        DetectCorners(splitGrayImage, corners);
+        DetectCorners(splitGrayImage, params, corners);
         if (i) {
             for (int j = 0; j < corners.size(); j++) {
                 corners[j].y += splitHeight * i;
@@ -1,12 +1,36 @@
 #ifndef PITCHANGLECORRECTION_FEATURES_DETECTION_H
 #define PITCHANGLECORRECTION_FEATURES_DETECTION_H
 
+#include <string>
 #include <opencv2/opencv.hpp>
 
 namespace pac {
 
+// 画像を縦に 3 分割した各領域で検出する特徴点の最大数と特徴点間の最小距離
+struct FeatureParameters {
+    int maxCorners;
+    double minDistance;
+};
+
+const FeatureParameters kDefaultFeatures = {50, 25};
+
+// 1 フレームあたり数千点を追跡する高密度モード
+const FeatureParameters kDenseFeatures = {2000, 6};
+
+// 各領域で 8 点 (findFundamentalMat の RANSAC に必要な数) を検出できる最小の点数.
+// 追跡後に残る点数はこれより少なくなり得るため, 推定時にも EstimateMotion で確認する
+const int kMinFeatures = 24;
+
+// 1 フレームあたりおよそ numFeatures 点となるパラメータ
+FeatureParameters MakeFeatureParameters(int numFeatures);
+
+// kMinFeatures 以上の整数でなければ false
+bool ParseFeatureCount(const std::string &text, int &_numFeatures);
+
 void DetectFeatures(const cv::Mat &grayImage, std::vector<cv::Point2f> &_features);
 
+void DetectFeatures(const cv::Mat &grayImage, const FeatureParameters &params, std::vector<cv::Point2f> &_features);
+
 
 } // namespace pac
 
@@ -4,19 +4,24 @@ namespace pac {
 
 const float kMinFlowLength = 1;
 const float kMaxFlowLength = 35;
+const int kFoeMinLines = 20;
+const int kFoeIterations = 64;
+const float kFoeInlierThreshold = 2.0;
+// これより短い移動量の対応点からは直線の向きが決まらない [px]
+const float kFoeMinDisplacement = 1e-3f;
 
 void CalcOpticalFlow(const cv::Mat &prevImage, const cv::Mat &currImage,
                      const std::vector<cv::Point2f> &prevFeatures, std::vector<cv::Point2f> &_currFeatures,
                      std::vector<uchar> &_featuresFound) {
     cv::Mat prevImageGray;
     if (prevImage.channels() == 1) {
-        prevImageGray = prevImage.clone();
+        prevImageGray = prevImage;
     } else {
         cv::cvtColor(prevImage, prevImageGray, cv::COLOR_BGR2GRAY);
     }
     cv::Mat currImageGray;
     if (currImage.channels() == 1) {
-        currImageGray = currImage.clone();
+        currImageGray = currImage;
     } else {
         cv::cvtColor(currImage, currImageGray, cv::COLOR_BGR2GRAY);
     }
@@ -57,93 +62,96 @@ void CalcOpticalFlow(const cv::Mat &prevImage, const cv::Mat &currImage,
 void
 CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage, std::vector<cv::Point2f> &_prevFeatures,
                          std::vector<cv::Point2f> &_currFeatures) {
+    CalcOpticalFlowTwoFrames(prevImage, currImage, kDefaultFeatures, _prevFeatures, _currFeatures);
+}
+
+void CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage, const FeatureParameters &params,
+                              std::vector<cv::Point2f> &_prevFeatures, std::vector<cv::Point2f> &_currFeatures) {
+    LKTracker tracker(params);
+    CalcOpticalFlowTwoFrames(prevImage, currImage, tracker, _prevFeatures, _currFeatures);
+}
+
+void CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage, Tracker &tracker,
+                              std::vector<cv::Point2f> &_prevFeatures, std::vector<cv::Point2f> &_currFeatures) {
     std::vector<cv::Point2f> prevFeatures;
-    DetectFeatures(prevImage, prevFeatures);
+    tracker.Initialize(prevImage, prevFeatures);
     std::vector<cv::Point2f> currFeatures;
     std::vector<uchar> featuresFound;
-    CalcOpticalFlow(prevImage, currImage, prevFeatures, currFeatures, featuresFound);
+    tracker.Track(prevImage, currImage, prevFeatures, currFeatures, featuresFound, kUncachedPair);
 
-    std::vector<cv::Point2f> prevFeaturesFound;
-    std::vector<cv::Point2f> currFeaturesFound;
-    for (int i = 0; i < featuresFound.size(); i++) {
-        if (!featuresFound[i]) {
-            continue;
-        }
-        if (cv::norm(prevFeatures[i] - currFeatures[i]) > kMaxFlowLength) {
-            featuresFound[i] = 0;
-            continue;
-        }
-        if (cv::norm(prevFeatures[i] - currFeatures[i]) < kMinFlowLength) {
-            featuresFound[i] = 0;
-            continue;
-        }
-        prevFeaturesFound.push_back(prevFeatures[i]);
-        currFeaturesFound.push_back(currFeatures[i]);
-    }
-    _prevFeatures = prevFeaturesFound;
-    _currFeatures = currFeaturesFound;
+    TrackSet tracks;
+    tracks.Reset(prevFeatures);
+    tracks.Advance(currFeatures, featuresFound, kMinFlowLength, kMaxFlowLength);
+    _prevFeatures = tracks.Origins();
+    _currFeatures = tracks.Positions();
     return;
 }
 
 void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, std::vector<cv::Point2f> &_prevFeaturesFound,
                                std::vector<cv::Point2f> &_currFeaturesFound) {
+    CalcOpticalFlowMultFrames(images, kDefaultFeatures, _prevFeaturesFound, _currFeaturesFound);
+}
+
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, const FeatureParameters &params,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound) {
+    LKTracker tracker(params);
+    CalcOpticalFlowMultFrames(images, tracker, _prevFeaturesFound, _currFeaturesFound);
+}
+
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, Tracker &tracker,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound) {
+    CalcOpticalFlowMultFrames(images, tracker, kUncachedPair, _prevFeaturesFound, _currFeaturesFound);
+}
+
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, Tracker &tracker, long long firstIndex,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound) {
     if (images.size() < 2) {
         fprintf(stderr, "error: more than 2 images are required\n");
         exit(1);
     }
-    std::vector<cv::Point2f> initialFeatures;
-    DetectFeatures(images.front(), initialFeatures);
-    const int size = initialFeatures.size();
-    uchar initialFlags[size];
-    for (int i = 0; i < size; i++) {
-        initialFlags[i] = 1;
+    if (firstIndex != kUncachedPair) {
+        tracker.BeginWindow(firstIndex);
     }
-    std::vector<cv::Point2f> prevFeatures;
-    std::copy(initialFeatures.begin(), initialFeatures.end(), std::back_inserter(prevFeatures));
+    std::vector<cv::Point2f> initialFeatures;
+    tracker.Initialize(images.front(), initialFeatures);
+    TrackSet tracks;
+    tracks.Reset(initialFeatures);
     std::vector<cv::Point2f> currFeatures;
     std::vector<uchar> foundFlags;
-    for (int i = 0; i < images.size() - 1; i++) {
-        CalcOpticalFlow(images[i], images[i + 1], prevFeatures, currFeatures, foundFlags);
-        std::vector<cv::Point2f> currFeaturesFound;
-        int k = 0;
-        for (int j = 0; j < size; j++) {
-            if (initialFlags[j]) {
-                if (foundFlags[k] && cv::norm(prevFeatures[k] - currFeatures[k]) <= kMaxFlowLength &&
-                    cv::norm(prevFeatures[k] - currFeatures[k]) >= kMinFlowLength) {
-                    currFeaturesFound.push_back(currFeatures[k]);
-                } else {
-                    initialFlags[j] = 0;
-                }
-                k++;
-            }
-        }
-        prevFeatures = currFeaturesFound;
+    for (int i = 0; i < images.size() - 1 && tracks.Size(); i++) {
+        const long long pairIndex = firstIndex == kUncachedPair ? kUncachedPair : firstIndex + i;
+        tracker.Track(images[i], images[i + 1], tracks.Positions(), currFeatures, foundFlags, pairIndex);
+        tracks.Advance(currFeatures, foundFlags, kMinFlowLength, kMaxFlowLength);
     }
-    std::vector<cv::Point2f> prevFeaturesFound;
-    for (int i = 0; i < size; i++) {
-        if (initialFlags[i]) {
-            prevFeaturesFound.push_back(initialFeatures[i]);
-        }
-    }
-    _prevFeaturesFound = prevFeaturesFound;
-    _currFeaturesFound = prevFeatures;
+    _prevFeaturesFound = tracks.Origins();
+    _currFeaturesFound = tracks.Positions();
 }
 
 void DrawOpticalFlow(const cv::Mat &image, const std::vector<cv::Point2f> &prevFeatures,
                      const std::vector<cv::Point2f> &currFeatures, LineType l, cv::Mat &_result, int thickness,
                      const cv::Scalar &color) {
     _result = image.clone();
+    DrawOpticalFlow(_result, prevFeatures, currFeatures, l, thickness, color);
+    return;
+}
+
+void DrawOpticalFlow(cv::Mat &_image, const std::vector<cv::Point2f> &prevFeatures,
+                     const std::vector<cv::Point2f> &currFeatures, LineType l, int thickness,
+                     const cv::Scalar &color) {
     switch (l) {
         case LINE_SEGMENT:
             for (int i = 0; i < prevFeatures.size(); i++) {
-                cv::line(_result, prevFeatures[i], currFeatures[i], color, thickness);
+                cv::line(_image, prevFeatures[i], currFeatures[i], color, thickness);
             }
             break;
         case STRAIGHT_LINE:
             // 直線 : ax+by+c=0
             std::vector<cv::Vec3f> lines;
             CalcLines(prevFeatures,currFeatures,lines);
-            DrawLines(image, lines, _result, thickness, color);
+            DrawLines(_image, lines, thickness, color);
             break;
     }
     return;
@@ -287,4 +295,104 @@ void CalcFocusOfExpansion(const cv::Mat &image, const std::vector<cv::Point2f> &
     return;
 }
 
+// lines[i] は prevFeatures[indices[i]] と currFeatures[indices[i]] を通る直線
+static int CountFoeInliers(const std::vector<cv::Vec3f> &lines, const std::vector<int> &indices,
+                           const std::vector<cv::Point2f> &prevFeatures,
+                           const std::vector<cv::Point2f> &currFeatures, const cv::Point2f &foe,
+                           std::vector<uchar> &_inliers) {
+    int count = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+        float distance = std::abs(lines[i][0] * foe.x + lines[i][1] * foe.y + lines[i][2]);
+        // 前進している場合, 特徴点は FOE から遠ざかる向きに動く
+        cv::Point2f flow = currFeatures[indices[i]] - prevFeatures[indices[i]];
+        cv::Point2f radial = prevFeatures[indices[i]] - foe;
+        _inliers[i] = distance < kFoeInlierThreshold && flow.dot(radial) > 0;
+        count += _inliers[i];
+    }
+    return count;
+}
+
+bool CalcRobustFocusOfExpansion(const std::vector<cv::Point2f> &prevFeatures,
+                                const std::vector<cv::Point2f> &currFeatures, cv::Point2f &_foe,
+                                std::vector<uchar> &_inliers, float &_residual) {
+    _inliers.assign(prevFeatures.size(), 0);
+    // 直線 : ax+by+c=0 (a^2+b^2=1 に正規化して点との距離を |ax+by+c| で求める).
+    // 移動していない対応点は正規化できない (NaN になる) ため除き, 元の番号を indices に残す
+    std::vector<cv::Vec3f> allLines;
+    CalcLines(prevFeatures, currFeatures, allLines);
+    std::vector<cv::Vec3f> lines;
+    std::vector<int> indices;
+    for (size_t i = 0; i < allLines.size(); i++) {
+        const cv::Vec3f &l = allLines[i];
+        float n = std::sqrt(l[0] * l[0] + l[1] * l[1]);
+        if (!(n >= kFoeMinDisplacement)) {
+            continue;
+        }
+        lines.push_back(cv::Vec3f(l[0] / n, l[1] / n, l[2] / n));
+        indices.push_back(static_cast<int>(i));
+    }
+    const int num = lines.size();
+    if (num < kFoeMinLines) {
+        return false;
+    }
+
+    // 2 本の直線の交点を候補とする RANSAC. 同じ入力には同じ結果を返すよう乱数の種を固定する
+    cv::RNG rng(0xFFFFFFFF);
+    std::vector<uchar> inliers(num);
+    std::vector<uchar> bestInliers(num, 0);
+    int bestCount = 0;
+    for (int k = 0; k < kFoeIterations; k++) {
+        int i = rng.uniform(0, num);
+        int j = rng.uniform(0, num);
+        const cv::Vec3f &l1 = lines[i];
+        const cv::Vec3f &l2 = lines[j];
+        float w = l1[0] * l2[1] - l1[1] * l2[0];
+        if (i == j || std::abs(w) < 1e-6) {
+            continue;
+        }
+        cv::Point2f candidate((l1[1] * l2[2] - l1[2] * l2[1]) / w, (l1[2] * l2[0] - l1[0] * l2[2]) / w);
+        int count = CountFoeInliers(lines, indices, prevFeatures, currFeatures, candidate, inliers);
+        if (count > bestCount) {
+            bestCount = count;
+            _foe = candidate;
+            bestInliers = inliers;
+        }
+    }
+    if (bestCount < 2) {
+        return false;
+    }
+
+    // インライアの直線までの距離の二乗和が最小となる点に補正する
+    double a11 = 0, a12 = 0, a22 = 0, b1 = 0, b2 = 0;
+    for (int i = 0; i < num; i++) {
+        if (!bestInliers[i]) {
+            continue;
+        }
+        const cv::Vec3f &l = lines[i];
+        a11 += l[0] * l[0];
+        a12 += l[0] * l[1];
+        a22 += l[1] * l[1];
+        b1 -= l[0] * l[2];
+        b2 -= l[1] * l[2];
+    }
+    double det = a11 * a22 - a12 * a12;
+    if (std::abs(det) < 1e-9) {
+        return false;
+    }
+    _foe = cv::Point2f((a22 * b1 - a12 * b2) / det, (a11 * b2 - a12 * b1) / det);
+    CountFoeInliers(lines, indices, prevFeatures, currFeatures, _foe, bestInliers);
+    for (int i = 0; i < num; i++) {
+        _inliers[indices[i]] = bestInliers[i];
+    }
+
+    // 残差は全ての直線と FOE の距離の中央値
+    std::vector<float> distances(num);
+    for (int i = 0; i < num; i++) {
+        distances[i] = std::abs(lines[i][0] * _foe.x + lines[i][1] * _foe.y + lines[i][2]);
+    }
+    std::nth_element(distances.begin(), distances.begin() + num / 2, distances.end());
+    _residual = distances[num / 2];
+    return true;
+}
+
 } // namespace pac
@@ -2,6 +2,8 @@
 #define PITCHANGLECORRECTION_OPTICAL_FLOW_H
 
 #include "feature_detection.hpp"
+#include "track_set.hpp"
+#include "tracker.hpp"
 #include "../geometry/geometry.hpp"
 #include <opencv2/opencv.hpp>
 
@@ -22,13 +24,37 @@ void CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage
                               std::vector<cv::Point2f> &_prevFeatures,
                               std::vector<cv::Point2f> &_currFeatures);
 
+void CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage, const FeatureParameters &params,
+                              std::vector<cv::Point2f> &_prevFeatures, std::vector<cv::Point2f> &_currFeatures);
+
+void CalcOpticalFlowTwoFrames(const cv::Mat &prevImage, const cv::Mat &currImage, Tracker &tracker,
+                              std::vector<cv::Point2f> &_prevFeatures, std::vector<cv::Point2f> &_currFeatures);
+
 void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, std::vector<cv::Point2f> &_prevFeaturesFound,
                                std::vector<cv::Point2f> &_currFeaturesFound);
 
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, const FeatureParameters &params,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound);
+
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, Tracker &tracker,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound);
+
+// firstIndex は images の先頭のストリーム内の番号. ウィンドウ間で重なるフレームの組の計算を tracker が使い回す
+void CalcOpticalFlowMultFrames(const std::deque<cv::Mat> &images, Tracker &tracker, long long firstIndex,
+                               std::vector<cv::Point2f> &_prevFeaturesFound,
+                               std::vector<cv::Point2f> &_currFeaturesFound);
+
 void DrawOpticalFlow(const cv::Mat &image, const std::vector<cv::Point2f> &prevFeatures,
                      const std::vector<cv::Point2f> &currFeatures, LineType l, cv::Mat &_result, int thickness = 4,
                      const cv::Scalar &color = cv::Scalar(0, 0, 255));
 
+// 複製せずに _image へ直接描画する
+void DrawOpticalFlow(cv::Mat &_image, const std::vector<cv::Point2f> &prevFeatures,
+                     const std::vector<cv::Point2f> &currFeatures, LineType l, int thickness = 4,
+                     const cv::Scalar &color = cv::Scalar(0, 0, 255));
+
 void Normalization(const cv::Mat &image, const std::vector<cv::Point2f> &prevFeatures,
                    const std::vector<cv::Point2f> &currFeatures, std::vector<cv::Point2f> &_prevNormalized,
                    std::vector<cv::Point2f> &_currNormalized);
@@ -43,6 +69,12 @@ void LineFilter(const std::vector<cv::Vec3f> &lines,const cv::Point2f &upperLeft
 void CalcFocusOfExpansion(const cv::Mat &image, const std::vector<cv::Point2f> &prevFeatures,
                           const std::vector<cv::Point2f> &currFeatures, cv::Point2f &_eof);
 
+// フローの直線から RANSAC で FOE を求める. 移動していない対応点は使わない.
+// _inliers は prevFeatures と同じ並び, _residual は使った直線と FOE の距離の中央値
+bool CalcRobustFocusOfExpansion(const std::vector<cv::Point2f> &prevFeatures,
+                                const std::vector<cv::Point2f> &currFeatures, cv::Point2f &_foe,
+                                std::vector<uchar> &_inliers, float &_residual);
+
 } // namespace pac
 
 #endif //PITCHANGLECORRECTION_OPTICAL_FLOW_H
@@ -0,0 +1,62 @@
+#include "track_set.hpp"
+
+namespace pac {
+
+void TrackSet::Reset(const std::vector<cv::Point2f> &features) {
+    origins_ = features;
+    positions_ = features;
+    ages_.assign(features.size(), 0);
+}
+
+void TrackSet::Advance(const std::vector<cv::Point2f> &nextPositions, const std::vector<uchar> &found,
+                       float minLength, float maxLength) {
+    const size_t size = positions_.size();
+    lengths_.resize(size);
+    alive_.resize(size);
+    const cv::Point2f *prev = positions_.data();
+    const cv::Point2f *next = nextPositions.data();
+    const uchar *foundFlags = found.data();
+    float *lengths = lengths_.data();
+    uchar *alive = alive_.data();
+    // sqrt を避けて長さの二乗で判定する. 分岐を含まないのでコンパイラがベクトル化できる
+    const float minSquared = minLength * minLength;
+    const float maxSquared = maxLength * maxLength;
+    for (size_t i = 0; i < size; i++) {
+        const float dx = next[i].x - prev[i].x;
+        const float dy = next[i].y - prev[i].y;
+        lengths[i] = dx * dx + dy * dy;
+    }
+    for (size_t i = 0; i < size; i++) {
+        alive[i] = (uchar) ((foundFlags[i] != 0) & (lengths[i] >= minSquared) & (lengths[i] <= maxSquared));
+    }
+
+    // 生き残った点を先頭から詰める
+    size_t k = 0;
+    for (size_t i = 0; i < size; i++) {
+        origins_[k] = origins_[i];
+        positions_[k] = next[i];
+        ages_[k] = ages_[i] + 1;
+        k += alive[i];
+    }
+    origins_.resize(k);
+    positions_.resize(k);
+    ages_.resize(k);
+}
+
+size_t TrackSet::Size() const {
+    return positions_.size();
+}
+
+const std::vector<cv::Point2f> &TrackSet::Origins() const {
+    return origins_;
+}
+
+const std::vector<cv::Point2f> &TrackSet::Positions() const {
+    return positions_;
+}
+
+const std::vector<int> &TrackSet::Ages() const {
+    return ages_;
+}
+
+} // namespace pac
@@ -0,0 +1,40 @@
+#ifndef PITCHANGLECORRECTION_TRACK_SET_HPP
+#define PITCHANGLECORRECTION_TRACK_SET_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+// 追跡中の特徴点の状態を属性ごとの連続した配列 (SoA) で持つ。
+// 追跡に失敗した点は Advance のたびに取り除かれ, 各配列は先頭から詰められる。
+class TrackSet {
+public:
+    void Reset(const std::vector<cv::Point2f> &features);
+
+    // nextPositions は Positions() と同じ順の追跡結果.
+    // found が 0 の点と, フローの長さが [minLength, maxLength] の範囲外の点を取り除く
+    void Advance(const std::vector<cv::Point2f> &nextPositions, const std::vector<uchar> &found, float minLength,
+                 float maxLength);
+
+    size_t Size() const;
+
+    // 追跡を始めたフレームでの位置
+    const std::vector<cv::Point2f> &Origins() const;
+
+    const std::vector<cv::Point2f> &Positions() const;
+
+    // 追跡できたフレーム間の数
+    const std::vector<int> &Ages() const;
+
+private:
+    std::vector<cv::Point2f> origins_;
+    std::vector<cv::Point2f> positions_;
+    std::vector<int> ages_;
+    std::vector<uchar> alive_;
+    std::vector<float> lengths_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_TRACK_SET_HPP
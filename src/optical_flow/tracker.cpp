@@ -0,0 +1,180 @@
+#include "tracker.hpp"
+#include "optical_flow.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+namespace pac {
+
+// DIS のパッチ (PRESET_FAST で 8 px) が 2 つ以上収まる ROI の最小の幅・高さ [px]
+const int kMinRoiSize = 16;
+
+TrackerOptions::TrackerOptions()
+        : type(SPARSE_LK),
+          features(kDefaultFeatures),
+          roi(0.1f, 0.55f, 0.8f, 0.4f),
+          gridStep(16) {
+}
+
+LKTracker::LKTracker(const FeatureParameters &params)
+        : params_(params) {
+}
+
+void LKTracker::Initialize(const cv::Mat &image, std::vector<cv::Point2f> &_features) {
+    DetectFeatures(image, params_, _features);
+}
+
+void LKTracker::Track(const cv::Mat &prevImage, const cv::Mat &currImage,
+                      const std::vector<cv::Point2f> &prevFeatures, std::vector<cv::Point2f> &_currFeatures,
+                      std::vector<uchar> &_featuresFound, long long /* pairIndex */) {
+    CalcOpticalFlow(prevImage, currImage, prevFeatures, _currFeatures, _featuresFound);
+}
+
+std::string LKTracker::Name() const {
+    return "lk";
+}
+
+DISTracker::DISTracker(const cv::Rect2f &roi, int gridStep)
+        : roi_(roi),
+          gridStep_(std::max(gridStep, 1)),
+          dis_(cv::DISOpticalFlow::create(cv::DISOpticalFlow::PRESET_FAST)) {
+}
+
+void DISTracker::BeginWindow(long long firstPair) {
+    // ウィンドウから外れた組のフローは領域だけを再利用する
+    while (!flows_.empty() && flows_.front().pairIndex < firstPair) {
+        spareFlows_.push_back(flows_.front().flow);
+        flows_.pop_front();
+    }
+}
+
+cv::Rect DISTracker::Roi(const cv::Size &imageSize) const {
+    cv::Rect roi(cvRound(roi_.x * imageSize.width), cvRound(roi_.y * imageSize.height),
+                 cvRound(roi_.width * imageSize.width), cvRound(roi_.height * imageSize.height));
+    roi = roi & cv::Rect(0, 0, imageSize.width, imageSize.height);
+    if (roi.width < kMinRoiSize || roi.height < kMinRoiSize) {
+        fprintf(stderr, "error: the dis roi is smaller than %dx%d px on %dx%d images\n", kMinRoiSize, kMinRoiSize,
+                imageSize.width, imageSize.height);
+        exit(1);
+    }
+    return roi;
+}
+
+void DISTracker::Initialize(const cv::Mat &image, std::vector<cv::Point2f> &_features) {
+    const cv::Rect roi = Roi(image.size());
+    std::vector<cv::Point2f> features;
+    features.reserve((roi.width / gridStep_ + 1) * (roi.height / gridStep_ + 1));
+    for (int y = roi.y + gridStep_ / 2; y < roi.y + roi.height; y += gridStep_) {
+        for (int x = roi.x + gridStep_ / 2; x < roi.x + roi.width; x += gridStep_) {
+            features.push_back(cv::Point2f(x, y));
+        }
+    }
+    _features = features;
+}
+
+void DISTracker::Track(const cv::Mat &prevImage, const cv::Mat &currImage,
+                       const std::vector<cv::Point2f> &prevFeatures, std::vector<cv::Point2f> &_currFeatures,
+                       std::vector<uchar> &_featuresFound, long long pairIndex) {
+    const cv::Mat &flow = Flow(prevImage, currImage, pairIndex);
+    const cv::Rect roi = Roi(prevImage.size());
+
+    const int num = prevFeatures.size();
+    _currFeatures.resize(num);
+    _featuresFound.resize(num);
+    for (int i = 0; i < num; i++) {
+        // ROI の端では双線形補間できないため 1 画素内側までを使う
+        const float x = prevFeatures[i].x - roi.x;
+        const float y = prevFeatures[i].y - roi.y;
+        if (x < 0 || y < 0 || x >= roi.width - 1 || y >= roi.height - 1) {
+            _currFeatures[i] = prevFeatures[i];
+            _featuresFound[i] = 0;
+            continue;
+        }
+        const int x0 = (int) x;
+        const int y0 = (int) y;
+        const float ax = x - x0;
+        const float ay = y - y0;
+        const cv::Point2f *row0 = flow.ptr<cv::Point2f>(y0) + x0;
+        const cv::Point2f *row1 = flow.ptr<cv::Point2f>(y0 + 1) + x0;
+        const float dx = (1 - ay) * ((1 - ax) * row0[0].x + ax * row0[1].x) +
+                         ay * ((1 - ax) * row1[0].x + ax * row1[1].x);
+        const float dy = (1 - ay) * ((1 - ax) * row0[0].y + ax * row0[1].y) +
+                         ay * ((1 - ax) * row1[0].y + ax * row1[1].y);
+        _currFeatures[i] = cv::Point2f(prevFeatures[i].x + dx, prevFeatures[i].y + dy);
+        _featuresFound[i] = 1;
+    }
+}
+
+const cv::Mat &DISTracker::Flow(const cv::Mat &prevImage, const cv::Mat &currImage, long long pairIndex) {
+    if (pairIndex == kUncachedPair) {
+        CalcFlow(prevImage, currImage, flow_);
+        return flow_;
+    }
+    for (const CachedFlow &cached : flows_) {
+        if (cached.pairIndex == pairIndex) {
+            return cached.flow;
+        }
+    }
+    CachedFlow cached;
+    cached.pairIndex = pairIndex;
+    if (!spareFlows_.empty()) {
+        cached.flow = spareFlows_.back();
+        spareFlows_.pop_back();
+    }
+    CalcFlow(prevImage, currImage, cached.flow);
+    flows_.push_back(cached);
+    return flows_.back().flow;
+}
+
+void DISTracker::CalcFlow(const cv::Mat &prevImage, const cv::Mat &currImage, cv::Mat &_flow) {
+    if (prevImage.channels() == 1) {
+        prevGray_ = prevImage;
+    } else {
+        cv::cvtColor(prevImage, prevGray_, cv::COLOR_BGR2GRAY);
+    }
+    if (currImage.channels() == 1) {
+        currGray_ = currImage;
+    } else {
+        cv::cvtColor(currImage, currGray_, cv::COLOR_BGR2GRAY);
+    }
+    // フローは ROI 内だけ求める
+    const cv::Rect roi = Roi(prevGray_.size());
+    dis_->calc(prevGray_(roi), currGray_(roi), _flow);
+}
+
+std::string DISTracker::Name() const {
+    return "dis";
+}
+
+std::unique_ptr<Tracker> CreateTracker(const TrackerOptions &options) {
+    if (options.type == DENSE_DIS) {
+        return std::unique_ptr<Tracker>(new DISTracker(options.roi, options.gridStep));
+    }
+    return std::unique_ptr<Tracker>(new LKTracker(options.features));
+}
+
+bool ParseTrackerType(const std::string &name, TrackerType &_type) {
+    if (name == "lk") {
+        _type = SPARSE_LK;
+    } else if (name == "dis") {
+        _type = DENSE_DIS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseRoi(const std::string &text, cv::Rect2f &_roi) {
+    cv::Rect2f roi;
+    char trailing;
+    if (sscanf(text.c_str(), "%f,%f,%f,%f%c", &roi.x, &roi.y, &roi.width, &roi.height, &trailing) != 4) {
+        return false;
+    }
+    if (roi.x < 0 || roi.y < 0 || roi.width <= 0 || roi.height <= 0 ||
+        roi.x + roi.width > 1 || roi.y + roi.height > 1) {
+        return false;
+    }
+    _roi = roi;
+    return true;
+}
+
+} // namespace pac
@@ -0,0 +1,116 @@
+#ifndef PITCHANGLECORRECTION_TRACKER_HPP
+#define PITCHANGLECORRECTION_TRACKER_HPP
+
+#include "feature_detection.hpp"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+enum TrackerType {
+    SPARSE_LK,  // goodFeaturesToTrack + calcOpticalFlowPyrLK
+    DENSE_DIS   // 路面の ROI 内の DIS オプティカルフローを格子状にサンプリング
+};
+
+struct TrackerOptions {
+    TrackerOptions();
+
+    TrackerType type;
+    // SPARSE_LK
+    FeatureParameters features;
+    // DENSE_DIS. roi は画像の幅・高さに対する割合
+    cv::Rect2f roi;
+    int gridStep;  // [px]
+};
+
+// Track の pairIndex に渡すと結果をキャッシュしない
+const long long kUncachedPair = -1;
+
+// フレーム間の対応点を求める方法
+class Tracker {
+public:
+    virtual ~Tracker() {}
+
+    // 先頭の組の番号が firstPair のウィンドウを処理し始める. それより前の組はもう渡されない
+    virtual void BeginWindow(long long /* firstPair */) {}
+
+    // 追跡を始める点を選ぶ
+    virtual void Initialize(const cv::Mat &image, std::vector<cv::Point2f> &_features) = 0;
+
+    // prevFeatures の currImage 上での位置を求める. 見つからなかった点は _featuresFound が 0.
+    // pairIndex はストリーム内での prevImage の番号で, 同じ番号には同じ画像の組を渡す.
+    // 画像の組ごとの計算結果を使い回せる実装はこれをキーにする
+    virtual void Track(const cv::Mat &prevImage, const cv::Mat &currImage,
+                       const std::vector<cv::Point2f> &prevFeatures, std::vector<cv::Point2f> &_currFeatures,
+                       std::vector<uchar> &_featuresFound, long long pairIndex) = 0;
+
+    virtual std::string Name() const = 0;
+};
+
+class LKTracker : public Tracker {
+public:
+    explicit LKTracker(const FeatureParameters &params = kDefaultFeatures);
+
+    void Initialize(const cv::Mat &image, std::vector<cv::Point2f> &_features);
+
+    void Track(const cv::Mat &prevImage, const cv::Mat &currImage, const std::vector<cv::Point2f> &prevFeatures,
+               std::vector<cv::Point2f> &_currFeatures, std::vector<uchar> &_featuresFound, long long pairIndex);
+
+    std::string Name() const;
+
+private:
+    const FeatureParameters params_;
+};
+
+// スライディングウィンドウでは同じフレームの組が interval - 1 回現れるため,
+// 組ごとのフローをキャッシュして新しい組だけを計算する
+class DISTracker : public Tracker {
+public:
+    DISTracker(const cv::Rect2f &roi, int gridStep);
+
+    void BeginWindow(long long firstPair);
+
+    void Initialize(const cv::Mat &image, std::vector<cv::Point2f> &_features);
+
+    void Track(const cv::Mat &prevImage, const cv::Mat &currImage, const std::vector<cv::Point2f> &prevFeatures,
+               std::vector<cv::Point2f> &_currFeatures, std::vector<uchar> &_featuresFound, long long pairIndex);
+
+    std::string Name() const;
+
+private:
+    struct CachedFlow {
+        long long pairIndex;
+        cv::Mat flow;
+    };
+
+    cv::Rect Roi(const cv::Size &imageSize) const;
+
+    const cv::Mat &Flow(const cv::Mat &prevImage, const cv::Mat &currImage, long long pairIndex);
+
+    void CalcFlow(const cv::Mat &prevImage, const cv::Mat &currImage, cv::Mat &_flow);
+
+    const cv::Rect2f roi_;
+    const int gridStep_;
+    cv::Ptr<cv::DISOpticalFlow> dis_;
+    cv::Mat prevGray_;
+    cv::Mat currGray_;
+    cv::Mat flow_;
+    std::deque<CachedFlow> flows_;  // 現在のウィンドウの組のみ. pairIndex の昇順
+    std::vector<cv::Mat> spareFlows_;
+};
+
+// DISOpticalFlow は内部状態を持つため, カメラ (スレッド) ごとに作る
+std::unique_ptr<Tracker> CreateTracker(const TrackerOptions &options);
+
+// "lk" または "dis"
+bool ParseTrackerType(const std::string &name, TrackerType &_type);
+
+// "X,Y,W,H" (画像の幅・高さに対する割合). 画像内に収まる面積のある矩形でなければ false
+bool ParseRoi(const std::string &text, cv::Rect2f &_roi);
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_TRACKER_HPP
@@ -0,0 +1,263 @@
+#include "camera_stream.hpp"
+#include "thread_budget.hpp"
+#include "../optical_flow/optical_flow.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace pac {
+
+const char *StageName(PipelineStage stage) {
+    switch (stage) {
+        case ENUMERATION_STAGE:
+            return "enumeration";
+        case DECODE_STAGE:
+            return "decode";
+        case TRACKING_STAGE:
+            return "tracking";
+        case ESTIMATION_STAGE:
+            return "estimation";
+        default:
+            return "unknown";
+    }
+}
+
+// 同じ入力に対して出力を変える設定を文字列にする
+static std::string DescribeSettings(const CameraConfig &config, const StreamOptions &options) {
+    std::ostringstream out;
+    out << std::setprecision(17)
+        << "mode=" << (options.mode == HEADING_PITCH ? "heading" : "rotation")
+        << " order=" << (options.order == NUMERIC_ORDER ? "numeric" : "lexicographic")
+        << " focal_length=" << config.camera.focalLength
+        << " principle_point=";
+    if (config.principlePointGiven || options.mode != HEADING_PITCH) {
+        out << config.camera.principlePoint.x << "," << config.camera.principlePoint.y;
+    } else {
+        out << "center";
+    }
+    if (options.tracker.type == DENSE_DIS) {
+        out << " tracker=dis roi=" << options.tracker.roi.x << "," << options.tracker.roi.y << ","
+            << options.tracker.roi.width << "," << options.tracker.roi.height
+            << " grid=" << options.tracker.gridStep;
+    } else {
+        out << " tracker=lk features=" << options.tracker.features.maxCorners << ","
+            << options.tracker.features.minDistance;
+    }
+    return out.str();
+}
+
+CameraConfig::CameraConfig()
+        : camera(kDefaultCamera),
+          principlePointGiven(false),
+          frameOffset(0) {
+}
+
+StreamOptions::StreamOptions()
+        : interval(6),
+          order(NUMERIC_ORDER),
+          listThreads(4),
+          mode(ROTATION_PITCH) {
+}
+
+CameraStream::CameraStream(const CameraConfig &config, const StreamOptions &options)
+        : config_(config),
+          settings_(DescribeSettings(config, options)),
+          options_(options),
+          files_(config.directory, options.order, options.listThreads),
+          frames_(options.interval, GRAY_IMAGE),
+          tracker_(CreateTracker(options.tracker)),
+          index_(-1),
+          stageCpuTimes_() {
+}
+
+bool CameraStream::Step(FrameResult &_result) {
+    Stopwatch stopwatch;
+    std::string filePath;
+    while (!frames_.Full() && NextFile(filePath)) {
+        Decode(filePath);
+        index_++;
+    }
+    if (!frames_.Full() || !NextFile(filePath)) {
+        return false;
+    }
+    std::vector<cv::Point2f> prevFeatures;
+    std::vector<cv::Point2f> currFeatures;
+    Stopwatch trackingStopwatch;
+    CpuStopwatch trackingCpuStopwatch;
+    const long long firstIndex = index_ - (long long) frames_.Frames().size() + 1;
+    CalcOpticalFlowMultFrames(frames_.Frames(), *tracker_, firstIndex, prevFeatures, currFeatures);
+    stageCosts_[TRACKING_STAGE].Add(trackingStopwatch.Elapsed());
+    stageCpuTimes_[TRACKING_STAGE] += trackingCpuStopwatch.Elapsed();
+    Stopwatch estimationStopwatch;
+    CpuStopwatch estimationCpuStopwatch;
+    _result.index = index_;
+    _result.path = frames_.Paths().back();
+    if (options_.mode == HEADING_PITCH) {
+        _result.rotationMat.release();
+        _result.translationVec.release();
+        _result.estimated = EstimatePitch(prevFeatures, currFeatures, config_.camera, _result.maskedPrevFeatures,
+                                          _result.maskedCurrFeatures, _result.pitch, _result.estimationPath);
+    } else {
+        _result.estimated = EstimateMotion(prevFeatures, currFeatures, config_.camera, _result.maskedPrevFeatures,
+                                           _result.maskedCurrFeatures, _result.rotationMat, _result.translationVec,
+                                           _result.pitch);
+        _result.estimationPath = RANSAC_PATH;
+    }
+    stageCosts_[ESTIMATION_STAGE].Add(estimationStopwatch.Elapsed());
+    stageCpuTimes_[ESTIMATION_STAGE] += estimationCpuStopwatch.Elapsed();
+    Decode(filePath);
+    index_++;
+    _result.latency = stopwatch.Elapsed();
+    latency_.Add(_result.latency);
+    return true;
+}
+
+void CameraStream::Save(Checkpoint &_checkpoint) const {
+    _checkpoint.directory = config_.directory;
+    _checkpoint.interval = options_.interval;
+    _checkpoint.settings = settings_;
+    _checkpoint.frameIndex = index_;
+    _checkpoint.window.assign(frames_.Paths().begin(), frames_.Paths().end());
+}
+
+void CameraStream::Restore(const Checkpoint &checkpoint) {
+    if (checkpoint.settings != settings_) {
+        fprintf(stderr, "error: checkpoint was saved with different options\n  checkpoint: %s\n  current:    %s\n",
+                checkpoint.settings.c_str(), settings_.c_str());
+        exit(1);
+    }
+    if (checkpoint.directory != config_.directory || checkpoint.interval != options_.interval ||
+        (long long) checkpoint.window.size() > checkpoint.frameIndex + 1) {
+        fprintf(stderr, "error: checkpoint does not match the input\n");
+        exit(1);
+    }
+    const long long windowBegin = checkpoint.frameIndex + 1 - (long long) checkpoint.window.size();
+    std::string filePath;
+    for (long long i = 0; i <= checkpoint.frameIndex; i++) {
+        if (!files_.Next(filePath)) {
+            fprintf(stderr, "error: checkpoint does not match the input\n");
+            exit(1);
+        }
+        if (i < windowBegin) {
+            continue;
+        }
+        if (filePath != checkpoint.window[i - windowBegin]) {
+            fprintf(stderr, "error: checkpoint does not match the input: %s\n", filePath.c_str());
+            exit(1);
+        }
+        Decode(filePath);
+    }
+    index_ = checkpoint.frameIndex;
+}
+
+bool CameraStream::NextFile(std::string &_filePath) {
+    Stopwatch stopwatch;
+    CpuStopwatch cpuStopwatch;
+    bool found = files_.Next(_filePath);
+    stageCosts_[ENUMERATION_STAGE].Add(stopwatch.Elapsed());
+    stageCpuTimes_[ENUMERATION_STAGE] += cpuStopwatch.Elapsed();
+    return found;
+}
+
+void CameraStream::Decode(const std::string &filePath) {
+    Stopwatch stopwatch;
+    CpuStopwatch cpuStopwatch;
+    frames_.Push(filePath);
+    stageCosts_[DECODE_STAGE].Add(stopwatch.Elapsed());
+    stageCpuTimes_[DECODE_STAGE] += cpuStopwatch.Elapsed();
+    // FOE からのピッチ角は主点に対する角度なので, 主点が未知なら画像の中心とする
+    if (!config_.principlePointGiven && options_.mode == HEADING_PITCH) {
+        const cv::Size size = frames_.Frames().back().size();
+        config_.camera.principlePoint = cv::Point2f(size.width / 2.0f, size.height / 2.0f);
+        config_.principlePointGiven = true;
+    }
+}
+
+const CameraConfig &CameraStream::Config() const {
+    return config_;
+}
+
+const LatencyRecorder &CameraStream::Latency() const {
+    return latency_;
+}
+
+const LatencyRecorder &CameraStream::TrackingCost() const {
+    return stageCosts_[TRACKING_STAGE];
+}
+
+const LatencyRecorder &CameraStream::StageCost(PipelineStage stage) const {
+    return stageCosts_[stage];
+}
+
+double CameraStream::StageCpuTime(PipelineStage stage) const {
+    return stageCpuTimes_[stage];
+}
+
+const Tracker &CameraStream::GetTracker() const {
+    return *tracker_;
+}
+
+void PrintStageUtilization(const std::vector<const CameraStream *> &streams, double wall, int threads,
+                           double processCpu, int cores, std::ostream &out) {
+    double total = 0.0;
+    double totalCpu = 0.0;
+    for (int stage = 0; stage < NUM_STAGES; stage++) {
+        double cost = 0.0;
+        double cpu = 0.0;
+        for (const CameraStream *stream : streams) {
+            cost += stream->StageCost(static_cast<PipelineStage>(stage)).Total();
+            cpu += stream->StageCpuTime(static_cast<PipelineStage>(stage));
+        }
+        if (stage == ENUMERATION_STAGE) {
+            PrintWaitTime(StageName(ENUMERATION_STAGE), cost, wall, threads, out);
+            continue;
+        }
+        PrintUtilization(StageName(static_cast<PipelineStage>(stage)), cost, cpu, wall, threads, out);
+        total += cost;
+        totalCpu += cpu;
+    }
+    PrintUtilization("total", total, totalCpu, wall, threads, out);
+    // OpenCV のスレッドプールや列挙, 可視化のスレッドを含めて, コアがどれだけ使われたか
+    PrintCpuUtilization("process", processCpu, wall, cores, out);
+}
+
+void LoadCameraConfigs(const std::string &path, std::vector<CameraConfig> &_configs) {
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        fprintf(stderr, "error: cannot open camera config %s\n", path.c_str());
+        exit(1);
+    }
+    std::vector<CameraConfig> configs;
+    cv::FileNode cameras = fs["cameras"];
+    for (cv::FileNodeIterator it = cameras.begin(); it != cameras.end(); ++it) {
+        CameraConfig config;
+        (*it)["name"] >> config.name;
+        (*it)["directory"] >> config.directory;
+        if (!(*it)["focal_length"].empty()) {
+            (*it)["focal_length"] >> config.camera.focalLength;
+        }
+        if (!(*it)["principle_point"].empty()) {
+            (*it)["principle_point"] >> config.camera.principlePoint;
+            config.principlePointGiven = true;
+        }
+        if (!(*it)["frame_offset"].empty()) {
+            int frameOffset;
+            (*it)["frame_offset"] >> frameOffset;
+            config.frameOffset = frameOffset;
+        }
+        if (config.directory.empty()) {
+            fprintf(stderr, "error: camera %s has no directory\n", config.name.c_str());
+            exit(1);
+        }
+        if (config.name.empty()) {
+            config.name = "camera" + std::to_string(configs.size());
+        }
+        configs.push_back(config);
+    }
+    if (configs.empty()) {
+        fprintf(stderr, "error: no cameras in %s\n", path.c_str());
+        exit(1);
+    }
+    _configs = configs;
+}
+
+} // namespace pac
@@ -0,0 +1,133 @@
+#ifndef PITCHANGLECORRECTION_CAMERA_STREAM_HPP
+#define PITCHANGLECORRECTION_CAMERA_STREAM_HPP
+
+#include "checkpoint.hpp"
+#include "latency_recorder.hpp"
+#include "../geometry/motion_estimation.hpp"
+#include "../image/camera.hpp"
+#include "../image/file_stream.hpp"
+#include "../image/frame_ring.hpp"
+#include "../optical_flow/tracker.hpp"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+enum PitchMode {
+    ROTATION_PITCH,  // ウィンドウの先頭と末尾のフレーム間の回転のピッチ成分
+    HEADING_PITCH    // 進行方向 (FOE) に対するカメラのピッチ角
+};
+
+struct CameraConfig {
+    CameraConfig();
+
+    std::string name;
+    std::string directory;
+    CameraParameters camera;
+    // false の場合, HEADING_PITCH では最初のフレームの中心を主点とする.
+    // ROTATION_PITCH では従来どおり camera.principlePoint をそのまま使う
+    bool principlePointGiven;
+    // 統合時のフレーム番号 = このカメラのフレーム番号 + frameOffset.
+    // 全カメラが同じフレームレートで撮影し, フレームの欠落がないことを前提とする
+    long long frameOffset;
+};
+
+// 処理時間を計測する段階
+enum PipelineStage {
+    ENUMERATION_STAGE,  // 次のファイルパスを待つ時間
+    DECODE_STAGE,
+    TRACKING_STAGE,
+    ESTIMATION_STAGE,
+    NUM_STAGES
+};
+
+const char *StageName(PipelineStage stage);
+
+// 全カメラ共通の処理の設定
+struct StreamOptions {
+    StreamOptions();
+
+    int interval;
+    SortOrder order;
+    int listThreads;
+    PitchMode mode;
+    TrackerOptions tracker;
+};
+
+// 1 フレーム分の推定結果
+struct FrameResult {
+    long long index;  // ウィンドウ末尾のフレーム番号
+    std::string path;
+    bool estimated;   // 対応点が足りず推定できなかった場合は false. 以下の推定結果は無効
+    double pitch;
+    EstimationPath estimationPath;
+    cv::Mat rotationMat;  // FOE_PATH の場合は空
+    cv::Mat translationVec;
+    std::vector<cv::Point2f> maskedPrevFeatures;
+    std::vector<cv::Point2f> maskedCurrFeatures;
+    double latency;  // [ms]
+};
+
+// 1 台のカメラのスライディングウィンドウと推定状態
+class CameraStream {
+public:
+    CameraStream(const CameraConfig &config, const StreamOptions &options);
+
+    // ウィンドウを 1 フレーム進めて推定する. 入力が尽きたら false
+    bool Step(FrameResult &_result);
+
+    // ウィンドウの状態を _checkpoint に書き込む. outputOffset は変更しない
+    void Save(Checkpoint &_checkpoint) const;
+
+    // checkpoint のフレームまで入力を読み飛ばし, ウィンドウのフレームだけを読み込み直す
+    void Restore(const Checkpoint &checkpoint);
+
+    const CameraConfig &Config() const;
+
+    const LatencyRecorder &Latency() const;
+
+    // 対応点探索 (特徴点の検出と追跡) にかかった時間
+    const LatencyRecorder &TrackingCost() const;
+
+    const LatencyRecorder &StageCost(PipelineStage stage) const;
+
+    // 段階ごとに呼び出し元のスレッドが消費した CPU 時間 [ms] の合計. OpenCV のスレッドプールの分は含まない
+    double StageCpuTime(PipelineStage stage) const;
+
+    const Tracker &GetTracker() const;
+
+private:
+    bool NextFile(std::string &_filePath);
+
+    void Decode(const std::string &filePath);
+
+    CameraConfig config_;
+    const std::string settings_;
+    const StreamOptions options_;
+    FileStream files_;
+    FrameRing frames_;
+    std::unique_ptr<Tracker> tracker_;
+    long long index_;
+    LatencyRecorder latency_;
+    LatencyRecorder stageCosts_[NUM_STAGES];
+    double stageCpuTimes_[NUM_STAGES];
+};
+
+// 全ストリームの段階ごとの処理時間と CPU 時間を, wall [ms] × threads に対する使用率として出力する.
+// 列挙は待ち時間なので使用率と合計 (total) には含めない. 最後に同じ区間のプロセス全体の CPU 時間
+// processCpu [ms] を wall × cores に対する使用率として出力する
+void PrintStageUtilization(const std::vector<const CameraStream *> &streams, double wall, int threads,
+                           double processCpu, int cores, std::ostream &out);
+
+// YAML / XML のカメラ設定を読み込む
+//  cameras:
+//    - { name: front, directory: /data/front, focal_length: 1280, principle_point: [ 640, 360 ] }
+//    - { name: rear, directory: /data/rear, frame_offset: 3 }  # front より 3 フレーム遅れて撮影を始めた場合
+void LoadCameraConfigs(const std::string &path, std::vector<CameraConfig> &_configs);
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_CAMERA_STREAM_HPP
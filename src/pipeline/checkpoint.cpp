@@ -0,0 +1,82 @@
+#include "checkpoint.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+void SaveCheckpoint(const std::string &path, const Checkpoint &checkpoint) {
+    const std::string tmpPath = path + ".tmp.yml";
+    {
+        cv::FileStorage fs(tmpPath, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            fprintf(stderr, "error: cannot write checkpoint %s\n", tmpPath.c_str());
+            exit(1);
+        }
+        fs << "directory" << checkpoint.directory;
+        fs << "interval" << checkpoint.interval;
+        fs << "settings" << checkpoint.settings;
+        // FileStorage は 64 bit 整数を持てないため文字列で保存する
+        fs << "frame_index" << std::to_string(checkpoint.frameIndex);
+        fs << "output_offset" << std::to_string(checkpoint.outputOffset);
+        fs << "window" << checkpoint.window;
+        fs.release();
+    }
+    // 置き換えた後に中断されても中身のあるチェックポイントが残るようにする
+    if (!SyncFile(tmpPath)) {
+        fprintf(stderr, "error: cannot write checkpoint %s\n", tmpPath.c_str());
+        exit(1);
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "error: cannot write checkpoint %s\n", path.c_str());
+        exit(1);
+    }
+}
+
+bool SyncFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+bool LoadCheckpoint(const std::string &path, Checkpoint &_checkpoint) {
+    Checkpoint checkpoint;
+    std::string frameIndex;
+    std::string outputOffset;
+    // 壊れたファイルは FileStorage が例外を投げる
+    try {
+        cv::FileStorage fs(path, cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            return false;
+        }
+        fs["directory"] >> checkpoint.directory;
+        fs["interval"] >> checkpoint.interval;
+        fs["settings"] >> checkpoint.settings;
+        fs["frame_index"] >> frameIndex;
+        fs["output_offset"] >> outputOffset;
+        fs["window"] >> checkpoint.window;
+    } catch (const cv::Exception &) {
+        return false;
+    }
+    if (frameIndex.empty() || outputOffset.empty() || checkpoint.settings.empty() || checkpoint.window.empty()) {
+        return false;
+    }
+    char *frameIndexEnd;
+    char *outputOffsetEnd;
+    checkpoint.frameIndex = strtoll(frameIndex.c_str(), &frameIndexEnd, 10);
+    checkpoint.outputOffset = strtoll(outputOffset.c_str(), &outputOffsetEnd, 10);
+    if (*frameIndexEnd != '\0' || *outputOffsetEnd != '\0' || checkpoint.frameIndex < 0 ||
+        checkpoint.outputOffset < 0) {
+        return false;
+    }
+    _checkpoint = checkpoint;
+    return true;
+}
+
+} // namespace pac
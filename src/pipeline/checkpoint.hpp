@@ -0,0 +1,29 @@
+#ifndef PITCHANGLECORRECTION_CHECKPOINT_HPP
+#define PITCHANGLECORRECTION_CHECKPOINT_HPP
+
+#include <string>
+#include <vector>
+
+namespace pac {
+
+// 処理を途中から再開するための状態
+struct Checkpoint {
+    std::string directory;
+    int interval;
+    std::string settings;             // 出力に影響する設定. 再開時に一致しなければならない
+    long long frameIndex;             // 最後にウィンドウへ読み込んだフレームの番号
+    std::vector<std::string> window;  // ウィンドウ内のフレームのパス (古い順)
+    long long outputOffset;           // 出力ファイルのうち書き込み済みのバイト数
+};
+
+// 一時ファイルに書いてから置き換えるため, 書き込み中に中断されても直前のチェックポイントが残る
+void SaveCheckpoint(const std::string &path, const Checkpoint &checkpoint);
+
+bool LoadCheckpoint(const std::string &path, Checkpoint &_checkpoint);
+
+// path の内容をディスクへ書き出す (fsync)
+bool SyncFile(const std::string &path);
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_CHECKPOINT_HPP
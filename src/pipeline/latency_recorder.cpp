@@ -0,0 +1,85 @@
+#include "latency_recorder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+namespace pac {
+
+void LatencyRecorder::Add(double milliseconds) {
+    samples_.push_back(milliseconds);
+}
+
+size_t LatencyRecorder::Count() const {
+    return samples_.size();
+}
+
+double LatencyRecorder::Mean() const {
+    if (samples_.empty()) {
+        return 0.0;
+    }
+    return Total() / samples_.size();
+}
+
+double LatencyRecorder::Percentile(double p) const {
+    if (samples_.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sorted(samples_);
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    rank = std::min(std::max(rank, (size_t) 1), sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+    return sorted[rank - 1];
+}
+
+double LatencyRecorder::Max() const {
+    if (samples_.empty()) {
+        return 0.0;
+    }
+    return *std::max_element(samples_.begin(), samples_.end());
+}
+
+double LatencyRecorder::Total() const {
+    double total = 0.0;
+    for (double s : samples_) {
+        total += s;
+    }
+    return total;
+}
+
+void LatencyRecorder::Print(const std::string &label, std::ostream &out) const {
+    out << label << ": frames=" << Count()
+        << " mean=" << Mean() << "ms"
+        << " p50=" << Percentile(50) << "ms"
+        << " p99=" << Percentile(99) << "ms"
+        << " max=" << Max() << "ms" << std::endl;
+}
+
+Stopwatch::Stopwatch()
+        : start_(std::chrono::steady_clock::now()) {
+}
+
+double Stopwatch::Elapsed() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
+
+static double CpuTime(clockid_t clock) {
+    struct timespec time;
+    if (clock_gettime(clock, &time) != 0) {
+        return 0.0;
+    }
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1e6;
+}
+
+CpuStopwatch::CpuStopwatch()
+        : start_(CpuTime(CLOCK_THREAD_CPUTIME_ID)) {
+}
+
+double CpuStopwatch::Elapsed() const {
+    return CpuTime(CLOCK_THREAD_CPUTIME_ID) - start_;
+}
+
+double ProcessCpuTime() {
+    return CpuTime(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+} // namespace pac
@@ -0,0 +1,60 @@
+#ifndef PITCHANGLECORRECTION_LATENCY_RECORDER_HPP
+#define PITCHANGLECORRECTION_LATENCY_RECORDER_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pac {
+
+// フレームごとの処理時間 [ms] を記録し, 統計量を求める
+class LatencyRecorder {
+public:
+    void Add(double milliseconds);
+
+    size_t Count() const;
+
+    double Mean() const;
+
+    // p は 0 から 100
+    double Percentile(double p) const;
+
+    double Max() const;
+
+    double Total() const;
+
+    void Print(const std::string &label, std::ostream &out) const;
+
+private:
+    std::vector<double> samples_;
+};
+
+// 経過時間 [ms] を測る
+class Stopwatch {
+public:
+    Stopwatch();
+
+    double Elapsed() const;
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 呼び出し元のスレッドが消費した CPU 時間 [ms] を測る. I/O やロックの待ちは含まない
+class CpuStopwatch {
+public:
+    CpuStopwatch();
+
+    double Elapsed() const;
+
+private:
+    double start_;
+};
+
+// プロセスの全スレッド (OpenCV のスレッドプールを含む) が消費した CPU 時間 [ms]
+double ProcessCpuTime();
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_LATENCY_RECORDER_HPP
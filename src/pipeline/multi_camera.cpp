@@ -0,0 +1,111 @@
+#include "multi_camera.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pac {
+
+MultiCameraRunner::MultiCameraRunner(const std::vector<CameraConfig> &configs, const StreamOptions &options,
+                                     ThreadPool &pool, bool fuse, std::ostream &out)
+        : pool_(pool),
+          fuse_(fuse),
+          out_(out),
+          reported_(configs.size(), std::numeric_limits<long long>::min()),
+          finished_(configs.size(), false),
+          active_(0),
+          wallTime_(0.0),
+          processCpuTime_(0.0) {
+    for (const CameraConfig &config : configs) {
+        streams_.push_back(std::unique_ptr<CameraStream>(new CameraStream(config, options)));
+    }
+}
+
+void MultiCameraRunner::Run() {
+    Stopwatch stopwatch;
+    const double processCpuStart = ProcessCpuTime();
+    active_ = static_cast<int>(streams_.size());
+    for (size_t i = 0; i < streams_.size(); i++) {
+        pool_.Submit([this, i] { Step(i); });
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    finishedChanged_.wait(lock, [this] { return active_ == 0; });
+    wallTime_ = stopwatch.Elapsed();
+    processCpuTime_ = ProcessCpuTime() - processCpuStart;
+}
+
+void MultiCameraRunner::PrintLatency(std::ostream &out) const {
+    for (const std::unique_ptr<CameraStream> &stream : streams_) {
+        stream->Latency().Print(stream->Config().name, out);
+        stream->TrackingCost().Print(stream->Config().name + " tracker " + stream->GetTracker().Name(), out);
+    }
+}
+
+void MultiCameraRunner::PrintUtilization(int cores, std::ostream &out) const {
+    std::vector<const CameraStream *> streams;
+    for (const std::unique_ptr<CameraStream> &stream : streams_) {
+        streams.push_back(stream.get());
+    }
+    PrintStageUtilization(streams, wallTime_, pool_.Size(), processCpuTime_, cores, out);
+}
+
+void MultiCameraRunner::Step(size_t camera) {
+    FrameResult result;
+    if (!streams_[camera]->Step(result)) {
+        Finish(camera);
+        return;
+    }
+    Report(camera, result);
+    // 他のカメラのタスクの後ろに並び直す
+    pool_.Submit([this, camera] { Step(camera); });
+}
+
+void MultiCameraRunner::Report(size_t camera, const FrameResult &result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 統合はカメラ間で揃えたフレーム番号で行う. 推定できなかったフレームも統合の進捗には含める
+    const long long frame = result.index + streams_[camera]->Config().frameOffset;
+    reported_[camera] = frame;
+    if (result.estimated) {
+        out_ << streams_[camera]->Config().name << "," << result.index << "," << result.path << ","
+             << result.pitch * 180 / M_PI << "," << (result.estimationPath == FOE_PATH ? "foe" : "ransac")
+             << std::endl;
+        if (fuse_) {
+            pitches_[frame].push_back(result.pitch);
+        }
+    }
+    if (fuse_) {
+        Fuse();
+    }
+}
+
+void MultiCameraRunner::Finish(size_t camera) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_[camera] = true;
+    if (fuse_) {
+        Fuse();
+    }
+    active_--;
+    finishedChanged_.notify_all();
+}
+
+void MultiCameraRunner::Fuse() {
+    // 処理中の全カメラが報告済みのフレーム番号までを出力する
+    long long complete = -1;
+    bool first = true;
+    for (size_t i = 0; i < streams_.size(); i++) {
+        if (finished_[i]) {
+            continue;
+        }
+        complete = first ? reported_[i] : std::min(complete, reported_[i]);
+        first = false;
+    }
+    while (!pitches_.empty() && (first || pitches_.begin()->first <= complete)) {
+        std::vector<double> &pitches = pitches_.begin()->second;
+        std::sort(pitches.begin(), pitches.end());
+        size_t n = pitches.size();
+        double median = n % 2 ? pitches[n / 2] : (pitches[n / 2 - 1] + pitches[n / 2]) / 2;
+        out_ << "fused," << pitches_.begin()->first << ",," << median * 180 / M_PI << "," << std::endl;
+        pitches_.erase(pitches_.begin());
+    }
+}
+
+} // namespace pac
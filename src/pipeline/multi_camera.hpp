@@ -0,0 +1,59 @@
+#ifndef PITCHANGLECORRECTION_MULTI_CAMERA_HPP
+#define PITCHANGLECORRECTION_MULTI_CAMERA_HPP
+
+#include "camera_stream.hpp"
+#include "thread_pool.hpp"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace pac {
+
+// 複数カメラのストリームを 1 つのスレッドプールで並列に処理する。
+// 各カメラは 1 フレーム処理するごとにキューの末尾へ戻るため, カメラ間で順番に (ラウンドロビンで) 処理される。
+class MultiCameraRunner {
+public:
+    // fuse が true の場合, 同じフレーム番号 (CameraConfig::frameOffset で揃えた番号) のピッチ角の中央値を
+    // 車両のピッチ角として出力する. 各カメラは同期して撮影されていることを前提とする
+    MultiCameraRunner(const std::vector<CameraConfig> &configs, const StreamOptions &options, ThreadPool &pool,
+                      bool fuse, std::ostream &out);
+
+    // 全てのストリームが尽きるまで処理する
+    void Run();
+
+    void PrintLatency(std::ostream &out) const;
+
+    // 全カメラの段階ごとの処理時間を, Run にかかった時間とプールのスレッド数に対する割合で出力する.
+    // プロセスの CPU 時間は Run にかかった時間と cores に対する割合で出力する
+    void PrintUtilization(int cores, std::ostream &out) const;
+
+private:
+    void Step(size_t camera);
+
+    void Report(size_t camera, const FrameResult &result);
+
+    void Finish(size_t camera);
+
+    void Fuse();
+
+    std::vector<std::unique_ptr<CameraStream>> streams_;
+    ThreadPool &pool_;
+    const bool fuse_;
+    std::ostream &out_;
+
+    std::vector<long long> reported_;
+    std::vector<bool> finished_;
+    std::map<long long, std::vector<double>> pitches_;
+    int active_;
+    double wallTime_;
+    double processCpuTime_;
+    std::mutex mutex_;
+    std::condition_variable finishedChanged_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_MULTI_CAMERA_HPP
@@ -0,0 +1,186 @@
+#include "thread_budget.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <sched.h>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+// glibc の CPU_SETSIZE
+const int kMaxCpus = 1024;
+
+bool ParseCpuList(const std::string &list, std::vector<int> &_cpus) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        const char *begin = range.c_str();
+        char *end;
+        long first = strtol(begin, &end, 10);
+        long last = first;
+        if (end == begin) {
+            return false;
+        }
+        if (*end == '-') {
+            begin = end + 1;
+            last = strtol(begin, &end, 10);
+            if (end == begin) {
+                return false;
+            }
+        }
+        if (*end != '\0' || first < 0 || last < first || last >= kMaxCpus) {
+            return false;
+        }
+        for (int cpu = static_cast<int>(first); cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    if (cpus.empty()) {
+        return false;
+    }
+    _cpus.swap(cpus);
+    return true;
+}
+
+// pthreads と TBB は並行に呼ばれた parallel_for_ を 1 つのプールで処理する
+// (pthreads はプールが使用中なら呼び出し元で逐次に実行する). OpenMP などは呼び出しごとにスレッドを用意する
+static bool SharesParallelPool(const std::string &framework) {
+    return framework.empty() || framework == "pthreads" || framework == "tbb";
+}
+
+// プロセスが現在実行を許されている CPU 番号. taskset やコンテナで制限されている場合はその範囲だけを返す
+static std::vector<int> CurrentCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < kMaxCpus && static_cast<int>(cpus.size()) < CPU_COUNT(&set); cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+ThreadBudget MakeThreadBudget(int cores, const std::vector<int> &cpus, int numStreams, int sequenceThreads,
+                              int stageThreads, int listThreads) {
+    ThreadBudget budget;
+    if (cores <= 0 && !cpus.empty()) {
+        cores = static_cast<int>(cpus.size());
+    }
+    if (cores <= 0) {
+        // hardware_concurrency はマシン全体のコア数を返すため, 既存の CPU 割り当てを優先する
+        std::vector<int> current = CurrentCpus();
+        cores = current.empty() ? static_cast<int>(std::thread::hardware_concurrency())
+                                : static_cast<int>(current.size());
+    }
+    if (!cpus.empty()) {
+        cores = std::min(cores, static_cast<int>(cpus.size()));
+    }
+    budget.cores = std::max(cores, 1);
+    budget.cpus.assign(cpus.begin(), cpus.begin() + std::min(cpus.size(), (size_t) budget.cores));
+
+    numStreams = std::max(numStreams, 1);
+    if (sequenceThreads <= 0) {
+        sequenceThreads = std::min(numStreams, budget.cores);
+    }
+    budget.sequenceThreads = std::max(sequenceThreads, 1);
+    budget.stageThreads = std::max(stageThreads, 0);
+
+    const char *framework = cv::currentParallelFramework();
+    budget.parallelFramework = framework ? framework : "";
+    if (SharesParallelPool(budget.parallelFramework)) {
+        // OpenCV のスレッドプールは全ワーカーで共有される. 呼び出し元のスレッドも処理に加わるため,
+        // 他のスレッドと合わせて cores を超えないよう残りのコア + 1 とする
+        budget.opencvThreads = std::max(budget.cores - budget.sequenceThreads - budget.stageThreads + 1, 1);
+    } else {
+        // ワーカーごとに opencvThreads 本のスレッドが動くため, 残りのコアをワーカー数で分ける
+        budget.opencvThreads = std::max((budget.cores - budget.stageThreads) / budget.sequenceThreads, 1);
+    }
+
+    // 列挙スレッドはほとんど I/O 待ちなのでコアを割り当てず, ストリーム数で按分した数を上限とする
+    budget.listThreads = std::max(std::min(listThreads, budget.cores / numStreams), 1);
+    return budget;
+}
+
+void ApplyThreadBudget(const ThreadBudget &budget) {
+    if (!budget.cpus.empty()) {
+#ifdef __linux__
+        // 割り当てられていない CPU を指定すると sched_setaffinity が失敗するため先に確かめる
+        std::vector<int> current = CurrentCpus();
+        for (int cpu : budget.cpus) {
+            if (!current.empty() && !std::binary_search(current.begin(), current.end(), cpu)) {
+                fprintf(stderr, "error: CPU %d is not in the current CPU affinity of the process\n", cpu);
+                exit(1);
+            }
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : budget.cpus) {
+            CPU_SET(cpu, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            fprintf(stderr, "error: cannot set CPU affinity\n");
+            exit(1);
+        }
+#else
+        fprintf(stderr, "warning: CPU affinity is not supported on this platform\n");
+#endif
+    }
+    cv::setNumThreads(budget.opencvThreads);
+}
+
+void PrintThreadBudget(const ThreadBudget &budget, std::ostream &out) {
+    out << "threads: cores=" << budget.cores
+        << " sequence=" << budget.sequenceThreads
+        << " stage=" << budget.stageThreads
+        << " list=" << budget.listThreads
+        << " opencv=" << budget.opencvThreads;
+    if (!budget.parallelFramework.empty()) {
+        out << " (" << budget.parallelFramework << ")";
+    }
+    if (!budget.cpus.empty()) {
+        out << " cpus=";
+        for (size_t i = 0; i < budget.cpus.size(); i++) {
+            out << (i ? "," : "") << budget.cpus[i];
+        }
+    }
+    out << std::endl;
+}
+
+void PrintUtilization(const std::string &label, double busy, double wall, int threads, std::ostream &out) {
+    double utilization = wall > 0 && threads > 0 ? busy / (wall * threads) : 0.0;
+    out << label << ": busy=" << busy << "ms utilization=" << utilization * 100 << "% of " << threads
+        << " thread" << (threads == 1 ? "" : "s") << std::endl;
+}
+
+void PrintUtilization(const std::string &label, double busy, double cpu, double wall, int threads,
+                      std::ostream &out) {
+    double utilization = wall > 0 && threads > 0 ? busy / (wall * threads) : 0.0;
+    double cpuUtilization = wall > 0 && threads > 0 ? cpu / (wall * threads) : 0.0;
+    out << label << ": busy=" << busy << "ms utilization=" << utilization * 100 << "% cpu=" << cpu
+        << "ms cpu utilization=" << cpuUtilization * 100 << "% of " << threads << " thread"
+        << (threads == 1 ? "" : "s") << std::endl;
+}
+
+void PrintCpuUtilization(const std::string &label, double cpu, double wall, int cores, std::ostream &out) {
+    double utilization = wall > 0 && cores > 0 ? cpu / (wall * cores) : 0.0;
+    out << label << ": cpu=" << cpu << "ms utilization=" << utilization * 100 << "% of " << cores << " core"
+        << (cores == 1 ? "" : "s") << std::endl;
+}
+
+void PrintWaitTime(const std::string &label, double wait, double wall, int threads, std::ostream &out) {
+    double share = wall > 0 && threads > 0 ? wait / (wall * threads) : 0.0;
+    out << label << ": wait=" << wait << "ms (" << share * 100 << "% of " << threads << " thread"
+        << (threads == 1 ? "" : "s") << ", not counted as busy)" << std::endl;
+}
+
+} // namespace pac
@@ -0,0 +1,50 @@
+#ifndef PITCHANGLECORRECTION_THREAD_BUDGET_HPP
+#define PITCHANGLECORRECTION_THREAD_BUDGET_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace pac {
+
+// コア数をシーケンス (カメラ) 単位の並列, 段階ごとのスレッド, OpenCV 内部の並列に振り分けた結果
+struct ThreadBudget {
+    int cores;
+    std::vector<int> cpus;  // プロセスを固定する CPU 番号. 空なら固定しない
+    int sequenceThreads;    // カメラを並列に処理するワーカー数
+    int stageThreads;       // 推定ループとは別に計算する段階 (可視化など) のスレッド数
+    int listThreads;        // 1 ストリームあたりのディレクトリ列挙スレッド数
+    int opencvThreads;      // cv::setNumThreads に渡すスレッド数
+    std::string parallelFramework;  // OpenCV の並列化バックエンド. なければ空
+};
+
+// "0-15,32-47" のような CPU 番号のリストを解釈する
+bool ParseCpuList(const std::string &list, std::vector<int> &_cpus);
+
+// cores と sequenceThreads は 0 なら自動で決める. cpus が指定された場合 cores はその数を超えない.
+// cpus がなければ cores の既定値はプロセスに割り当て済みの CPU 数とする
+ThreadBudget MakeThreadBudget(int cores, const std::vector<int> &cpus, int numStreams, int sequenceThreads,
+                              int stageThreads, int listThreads);
+
+// スレッドを作る前に呼ぶ. 以降に作られるスレッドは CPU の割り当てを引き継ぐ.
+// cpus が現在の割り当てに含まれない CPU を含む場合はエラーで終了する
+void ApplyThreadBudget(const ThreadBudget &budget);
+
+void PrintThreadBudget(const ThreadBudget &budget, std::ostream &out);
+
+// busy [ms] が wall [ms] × threads のうち何割を占めたかを出力する
+void PrintUtilization(const std::string &label, double busy, double wall, int threads, std::ostream &out);
+
+// cpu [ms] は同じ区間に呼び出し元のスレッドが消費した CPU 時間. busy との差は I/O などで待っていた時間
+void PrintUtilization(const std::string &label, double busy, double cpu, double wall, int threads,
+                      std::ostream &out);
+
+// プロセス全体の CPU 時間 [ms] が wall [ms] × cores のうち何割を占めたかを出力する
+void PrintCpuUtilization(const std::string &label, double cpu, double wall, int cores, std::ostream &out);
+
+// 入力などを待っていた時間 [ms] を出力する. 使用率には含めない
+void PrintWaitTime(const std::string &label, double wait, double wall, int threads, std::ostream &out);
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_THREAD_BUDGET_HPP
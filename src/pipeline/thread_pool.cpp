@@ -0,0 +1,53 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace pac {
+
+ThreadPool::ThreadPool(int numThreads)
+        : stopped_(false) {
+    for (int i = 0; i < std::max(numThreads, 1); i++) {
+        workers_.push_back(std::thread(&ThreadPool::Run, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    changed_.notify_all();
+    for (std::thread &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    changed_.notify_one();
+}
+
+int ThreadPool::Size() const {
+    return static_cast<int>(workers_.size());
+}
+
+void ThreadPool::Run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this] { return !tasks_.empty() || stopped_; });
+            // 停止時も残っているタスクは実行してから終了する
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace pac
@@ -0,0 +1,36 @@
+#ifndef PITCHANGLECORRECTION_THREAD_POOL_HPP
+#define PITCHANGLECORRECTION_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pac {
+
+// 固定数のワーカースレッド. タスクは投入された順 (FIFO) に実行される
+class ThreadPool {
+public:
+    explicit ThreadPool(int numThreads);
+
+    ~ThreadPool();
+
+    void Submit(std::function<void()> task);
+
+    int Size() const;
+
+private:
+    void Run();
+
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_THREAD_POOL_HPP
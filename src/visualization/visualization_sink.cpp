@@ -0,0 +1,94 @@
+#include "visualization_sink.hpp"
+#include "../image/image_io.hpp"
+#include "../pipeline/latency_recorder.hpp"
+
+namespace pac {
+
+VisualizationSink::VisualizationSink(const std::string &videoPath, int samplingRate, double fps, LineType lineType,
+                                     int queueSize)
+        : videoPath_(videoPath),
+          samplingRate_(std::max(samplingRate, 1)),
+          fps_(fps),
+          lineType_(lineType),
+          queueSize_(static_cast<size_t>(std::max(queueSize, 1))),
+          pushed_(0),
+          busyTime_(0.0),
+          closed_(false) {
+    thread_ = std::thread(&VisualizationSink::Run, this);
+}
+
+VisualizationSink::~VisualizationSink() {
+    Close();
+}
+
+void VisualizationSink::Push(const std::string &framePath, std::vector<cv::Point2f> prevFeatures,
+                             std::vector<cv::Point2f> currFeatures) {
+    // 間引かれるフレームはキューに積まない
+    if (pushed_++ % samplingRate_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this] { return jobs_.size() < queueSize_ || closed_; });
+    if (closed_) {
+        return;
+    }
+    Job job;
+    job.framePath = framePath;
+    job.prevFeatures.swap(prevFeatures);
+    job.currFeatures.swap(currFeatures);
+    jobs_.push_back(std::move(job));
+    notEmpty_.notify_one();
+}
+
+void VisualizationSink::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+    thread_.join();
+    writer_.release();
+}
+
+double VisualizationSink::BusyTime() const {
+    return busyTime_;
+}
+
+void VisualizationSink::Run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this] { return !jobs_.empty() || closed_; });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        notFull_.notify_one();
+        Stopwatch stopwatch;
+        Write(job);
+        busyTime_ += stopwatch.Elapsed();
+    }
+}
+
+void VisualizationSink::Write(const Job &job) {
+    // canvas_ の領域を使い回してデコードし、そのまま上書きで描画する
+    readColorImage(job.framePath, canvas_);
+    DrawOpticalFlow(canvas_, job.prevFeatures, job.currFeatures, lineType_);
+    if (!writer_.isOpened()) {
+        const int fourcc = cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+        if (!writer_.open(videoPath_, fourcc, fps_, canvas_.size(), true)) {
+            fprintf(stderr, "error: cannot open video file %s\n", videoPath_.c_str());
+            exit(1);
+        }
+    }
+    writer_.write(canvas_);
+}
+
+} // namespace pac
@@ -0,0 +1,66 @@
+#ifndef PITCHANGLECORRECTION_VISUALIZATION_SINK_HPP
+#define PITCHANGLECORRECTION_VISUALIZATION_SINK_HPP
+
+#include "../optical_flow/optical_flow.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace pac {
+
+// 推定ループとは別スレッドでオプティカルフローを描画し、動画ファイルへ書き出す。
+// 描画対象のカラー画像はこのスレッドでデコードするため、推定ループはカラー画素に触れない。
+class VisualizationSink {
+public:
+    // samplingRate フレームごとに 1 フレームを書き出す
+    VisualizationSink(const std::string &videoPath, int samplingRate = 1, double fps = 10.0,
+                      LineType lineType = STRAIGHT_LINE, int queueSize = 4);
+
+    ~VisualizationSink();
+
+    void Push(const std::string &framePath, std::vector<cv::Point2f> prevFeatures,
+              std::vector<cv::Point2f> currFeatures);
+
+    // キューに残ったフレームを書き出してからスレッドを終了する
+    void Close();
+
+    // 描画と書き出しにかかった時間の合計 [ms]. Close の後に呼ぶ
+    double BusyTime() const;
+
+private:
+    struct Job {
+        std::string framePath;
+        std::vector<cv::Point2f> prevFeatures;
+        std::vector<cv::Point2f> currFeatures;
+    };
+
+    void Run();
+
+    void Write(const Job &job);
+
+    const std::string videoPath_;
+    const int samplingRate_;
+    const double fps_;
+    const LineType lineType_;
+    const size_t queueSize_;
+    long long pushed_;
+
+    double busyTime_;
+    cv::Mat canvas_;
+    cv::VideoWriter writer_;
+
+    std::deque<Job> jobs_;
+    bool closed_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::thread thread_;
+};
+
+} // namespace pac
+
+#endif //PITCHANGLECORRECTION_VISUALIZATION_SINK_HPP